@@ -0,0 +1,119 @@
+/* Microbenchmark comparing the getline() loop the dialogs used to have
+ * with line_reader, see bench/run.sh
+ *
+ * usage: line_reader FILE [RUNS]
+ *
+ * Both readers go through the whole file RUNS times (default 5) and the
+ * best time of each is printed as a JSON line on stderr.  The file should
+ * be in the page cache, so that only the cost of splitting lines is
+ * measured.
+ */
+
+#include <vector>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "line_reader.hpp"
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* sum up the first byte of each line so the loops can't be optimized away */
+static double run_getline(const char *file, size_t &lines, size_t &sum)
+{
+  FILE *fp = fopen(file, "r");
+  char *line = NULL;
+  size_t n = 0;
+  double start = now();
+
+  if (!fp) {
+    perror("fopen()");
+    exit(1);
+  }
+
+  while (getline(&line, &n, fp) != -1) {
+    lines++;
+    sum += static_cast<unsigned char>(line[0]);
+  }
+
+  double t = now() - start;
+  free(line);
+  fclose(fp);
+  return t;
+}
+
+static double run_line_reader(const char *file, size_t &lines, size_t &sum)
+{
+  int fd = open(file, O_RDONLY);
+  std::vector<line_view> batch;
+  double start = now();
+
+  if (fd == -1) {
+    perror("open()");
+    exit(1);
+  }
+
+  line_reader reader(fd);
+
+  while (reader.next_batch(batch)) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+      sum += static_cast<unsigned char>(batch[i].data[0]);
+    }
+    lines += batch.size();
+  }
+
+  double t = now() - start;
+  close(fd);
+  return t;
+}
+
+int main(int argc, char **argv)
+{
+  double best_getline = 0, best_reader = 0;
+  size_t lines_getline = 0, lines_reader = 0, sum = 0;
+  int runs = 5;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE [RUNS]\n", argv[0]);
+    return 1;
+  }
+
+  if (argc > 2) {
+    runs = atoi(argv[2]);
+  }
+
+  for (int i = 0; i < runs; ++i) {
+    size_t l1 = 0, l2 = 0;
+    double t1 = run_getline(argv[1], l1, sum);
+    double t2 = run_line_reader(argv[1], l2, sum);
+
+    if (i == 0 || t1 < best_getline) {
+      best_getline = t1;
+    }
+    if (i == 0 || t2 < best_reader) {
+      best_reader = t2;
+    }
+    lines_getline = l1;
+    lines_reader = l2;
+  }
+
+  if (lines_getline != lines_reader) {
+    fprintf(stderr, "line count mismatch: getline %zu, line_reader %zu\n", lines_getline, lines_reader);
+    return 1;
+  }
+
+  fprintf(stderr,
+    "{\"lines\":%zu,\"getline_seconds\":%.4f,\"getline_lines_per_second\":%.0f,"
+    "\"line_reader_seconds\":%.4f,\"line_reader_lines_per_second\":%.0f,\"speedup\":%.2f,\"checksum\":%zu}\n",
+    lines_reader, best_getline, lines_getline / best_getline,
+    best_reader, lines_reader / best_reader, best_getline / best_reader, sum);
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+/* Synthetic line producer for bench/run.sh
+ *
+ * usage: producer [-m progress|text] [-r LINES_PER_SECOND] [-n LINES] [-s LINE_SIZE]
+ *
+ * A rate of 0 writes as fast as the consumer reads, so the achieved rate
+ * printed at the end is the sustained ingest rate of the dialog.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+  const char *mode = "text";
+  double rate = 0;
+  unsigned long lines = 100000, sent = 0;
+  size_t size = 80;
+  char *line;
+  double start, elapsed;
+  int c;
+
+  while ((c = getopt(argc, argv, "m:r:n:s:")) != -1) {
+    switch (c) {
+      case 'm': mode = optarg; break;
+      case 'r': rate = atof(optarg); break;
+      case 'n': lines = strtoul(optarg, NULL, 10); break;
+      case 's': size = strtoul(optarg, NULL, 10); break;
+      default:
+        fprintf(stderr, "usage: %s [-m progress|text] [-r LINES_PER_SECOND] [-n LINES] [-s LINE_SIZE]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (size < 16) {
+    size = 16;
+  }
+  line = malloc(size + 1);
+  start = now();
+
+  while (sent < lines) {
+    /* number of lines that should have been written by now */
+    unsigned long due = (rate > 0) ? (unsigned long)((now() - start) * rate) + 1 : lines;
+
+    if (due > lines) {
+      due = lines;
+    }
+
+    for ( ; sent < due; ++sent) {
+      if (strcmp(mode, "progress") == 0) {
+        printf("%lu\n", (sent + 1 == lines) ? 100 : sent % 100);
+      } else {
+        int n = snprintf(line, size + 1, "line %010lu ", sent);
+        memset(line + n, 'x', size - n);
+        line[size] = '\0';
+        puts(line);
+      }
+    }
+    fflush(stdout);
+
+    if (sent < lines) {
+      struct timespec ts = { 0, 1000000 };  /* 1 ms */
+      nanosleep(&ts, NULL);
+    }
+  }
+
+  elapsed = now() - start;
+  fprintf(stderr, "{\"producer_lines\":%lu,\"producer_seconds\":%.3f,\"producer_lines_per_second\":%.0f}\n",
+          sent, elapsed, (elapsed > 0) ? sent / elapsed : 0);
+
+  free(line);
+  return 0;
+}
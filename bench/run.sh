@@ -0,0 +1,61 @@
+#!/bin/sh
+# Drive the stdin-based dialogs with a synthetic producer and print
+# ingest rate, input-to-pixel latency percentiles, window flushes,
+# CPU time and peak RSS as JSON lines on stderr.
+#
+# The dialog must be built with instrumentation:
+#   BENCHMARK=1 ./build.sh
+#
+# usage: bench/run.sh [progress|text-info] [LINES_PER_SECOND] [LINES] [LINE_SIZE]
+#   LINES_PER_SECOND=0 (default) means as fast as the dialog can read.
+#
+#        bench/run.sh lines [LINES] [LINE_SIZE]
+#   Compares line_reader with a getline() loop, no display needed.
+#
+# Runs under Xvfb (xvfb-run) if DISPLAY is not set.
+
+set -e
+
+top="$(cd "$(dirname "$0")/.." && pwd)"
+bin="${FLTK_DIALOG:-$top/build/fltk_dialog/fltk-dialog}"
+dialog="${1:-progress}"
+rate="${2:-0}"
+lines="${3:-100000}"
+size="${4:-80}"
+
+tmp="${TMPDIR:-/tmp}/fltk-dialog-bench"
+mkdir -p "$tmp"
+${CC:-cc} -O2 -o "$tmp/producer" "$top/bench/producer.c"
+
+if [ "$dialog" = "lines" ]; then
+  lines="${2:-5000000}"
+  size="${3:-80}"
+  ${CXX:-c++} -O2 -I"$top/src" -o "$tmp/line_reader" "$top/bench/line_reader.cpp" "$top/src/line_reader.cpp"
+  "$tmp/producer" -m text -n "$lines" -s "$size" > "$tmp/lines.txt"
+  "$tmp/line_reader" "$tmp/lines.txt"
+  rm -f "$tmp/lines.txt"
+  exit 0
+fi
+
+case "$dialog" in
+  progress)
+    args="--progress --auto-close"
+    mode="progress"
+    ;;
+  text-info)
+    args="--text-info --auto-close --auto-scroll"
+    mode="text"
+    ;;
+  *)
+    echo "unknown dialog: $dialog" >&2
+    exit 1
+    ;;
+esac
+
+cmd="'$tmp/producer' -m $mode -r $rate -n $lines -s $size | '$bin' $args"
+
+if [ -z "$DISPLAY" ]; then
+  xvfb-run -a sh -c "$cmd"
+else
+  sh -c "$cmd"
+fi
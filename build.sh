@@ -17,6 +17,12 @@ elif [ "x$1" = "x--disable-dlopen" ]; then
   syslibs="OFF"
 fi
 
+# the text-info dialog uses zlib directly; use fltk's copy if it's bundled
+zlib_cflags=""
+if [ "$syslibs" = "OFF" ]; then
+  zlib_cflags="-I$PWD/fltk/zlib"
+fi
+
 mkdir -p build
 
 
@@ -71,8 +77,8 @@ fi
 V=1 \
 USE_EXTERNAL_PLUGINS="$external_plugins" \
 USE_DLOPEN="$use_dlopen" \
-CXXFLAGS="$DEF_CXXFLAGS -I$PWD/fltk -I$PWD/../fltk $(./fltk/bin/fltk-config --use-images --cxxflags) $define_git_hash" \
-LDFLAGS="$DEF_LDFLAGS -L$PWD/fltk/lib $(./fltk/bin/fltk-config --use-images --ldflags) $(pkg-config --libs pangoxft) -lmagic" \
+CXXFLAGS="$DEF_CXXFLAGS -I$PWD/fltk -I$PWD/../fltk $zlib_cflags $(./fltk/bin/fltk-config --use-images --cxxflags) $define_git_hash" \
+LDFLAGS="$DEF_LDFLAGS -L$PWD/fltk/lib $(./fltk/bin/fltk-config --use-images --ldflags) $(pkg-config --libs pangoxft fontconfig) -lmagic" \
 QT_CXXFLAGS="$DEF_CXXFLAGS $(pkg-config --cflags Qt5Widgets Qt5Core)" \
 QT_LDFLAGS="$DEF_LDFLAGS $(pkg-config --libs Qt5Widgets Qt5Core)" \
 BUILDDIR="$PWD/fltk_dialog" \
@@ -24,7 +24,7 @@
 
 #include "fltk-dialog.hpp"
 #include "about_license.hpp"
-#include "fltk_png.h"
+#include "fltk_rgba.h"
 
 static Fl_Double_Window *win;
 static Fl_Text_Buffer *buffer;
@@ -84,7 +84,7 @@ int about()
   const int w = 500, h = 500;
   int range_w = 40;
 
-  Fl_PNG_Image *logo = new Fl_PNG_Image(NULL, fltk_png, fltk_png_len);
+  Fl_RGB_Image *logo = rgba_image(fltk_rgba);
   int logo_h = logo->h();
 
   win = new Fl_Double_Window(w, h, "FLTK dialog");
@@ -0,0 +1,457 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+cat <<EOF2 | ./build/fltk_dialog/fltk-dialog --batch=-
+# one argv per line, quoted like in a shell ...
+--question --text="Install the program?"
+--directory --title='Installation directory'
+# ... or as a JSON array of strings
+["--message", "--text=Done."]
+EOF2
+*/
+
+/* Every step is run in a child forked from this process, so the steps share
+ * the process startup and the preloaded font configuration (see
+ * preload_fonts()), but start with a clean state like a separate
+ * invocation would.  The icons are decoded at build time anyway.  Opening
+ * the X connection, the Xft/Pango font setup and the scheme are still done
+ * by every step, since an X connection cannot be shared across fork().
+ *
+ * The output of a step is captured in a memfd and printed as one JSON
+ * record per line once the step has finished:
+ *   {"step":1,"exit":0,"stdout":"..."}
+ *
+ * A step that doesn't exit with 0 isn't necessarily an error (a "No" to
+ * --question returns 1), so all steps are run and the exit code of the
+ * last one is returned.  With stop_on_error the batch stops at the first
+ * such step and returns its exit code.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "fltk-dialog.hpp"
+#include "trace.hpp"
+
+typedef std::vector<std::string> step_t;
+
+static void append_utf8(std::string &s, unsigned long c)
+{
+  if (c < 0x80) {
+    s.push_back(c);
+  } else if (c < 0x800) {
+    s.push_back(0xC0 | (c >> 6));
+    s.push_back(0x80 | (c & 0x3F));
+  } else if (c < 0x10000) {
+    s.push_back(0xE0 | (c >> 12));
+    s.push_back(0x80 | ((c >> 6) & 0x3F));
+    s.push_back(0x80 | (c & 0x3F));
+  } else {
+    s.push_back(0xF0 | (c >> 18));
+    s.push_back(0x80 | ((c >> 12) & 0x3F));
+    s.push_back(0x80 | ((c >> 6) & 0x3F));
+    s.push_back(0x80 | (c & 0x3F));
+  }
+}
+
+static const char *skip_space(const char *p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+    ++p;
+  }
+  return p;
+}
+
+static bool parse_hex4(const char *p, unsigned long &c)
+{
+  c = 0;
+
+  for (int i = 0; i < 4; ++i) {
+    int d = p[i];
+
+    if (d >= '0' && d <= '9') {
+      d -= '0';
+    } else if (d >= 'a' && d <= 'f') {
+      d -= 'a' - 10;
+    } else if (d >= 'A' && d <= 'F') {
+      d -= 'A' - 10;
+    } else {
+      return false;
+    }
+    c = (c << 4) | d;
+  }
+  return true;
+}
+
+/* parse a JSON string starting at the opening quote */
+static const char *parse_json_string(const char *p, std::string &s)
+{
+  unsigned long c, lo;
+
+  for (++p; *p != '"'; ++p) {
+    if (*p == '\0') {
+      return NULL;
+    } else if (*p != '\\') {
+      s.push_back(*p);
+      continue;
+    }
+
+    switch (*++p) {
+      case '"': case '\\': case '/': s.push_back(*p); break;
+      case 'b': s.push_back('\b'); break;
+      case 'f': s.push_back('\f'); break;
+      case 'n': s.push_back('\n'); break;
+      case 'r': s.push_back('\r'); break;
+      case 't': s.push_back('\t'); break;
+      case 'u':
+        if (!parse_hex4(p + 1, c)) {
+          return NULL;
+        }
+        p += 4;
+
+        /* surrogate pair */
+        if (c >= 0xD800 && c <= 0xDBFF && p[1] == '\\' && p[2] == 'u' && parse_hex4(p + 3, lo) &&
+            lo >= 0xDC00 && lo <= 0xDFFF)
+        {
+          c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+          p += 6;
+        }
+        append_utf8(s, c);
+        break;
+      default:
+        return NULL;
+    }
+  }
+
+  return p + 1;
+}
+
+/* parse a JSON array of strings starting at `[' */
+static const char *parse_json_step(const char *p, step_t &step)
+{
+  p = skip_space(p + 1);
+
+  if (*p == ']') {
+    return p + 1;
+  }
+
+  for (;;) {
+    std::string s;
+
+    if (*p != '"' || (p = parse_json_string(p, s)) == NULL) {
+      return NULL;
+    }
+    step.push_back(s);
+    p = skip_space(p);
+
+    if (*p == ']') {
+      return p + 1;
+    } else if (*p != ',') {
+      return NULL;
+    }
+    p = skip_space(p + 1);
+  }
+}
+
+/* split a line into words like a shell does, without any expansions */
+static bool parse_shell_step(const char *p, step_t &step)
+{
+  for (;;) {
+    std::string s;
+    bool word = false;
+
+    while (*p == ' ' || *p == '\t') {
+      ++p;
+    }
+
+    if (*p == '\0' || *p == '#') {
+      return true;
+    }
+
+    for ( ; *p != '\0' && *p != ' ' && *p != '\t'; ++p) {
+      word = true;
+
+      if (*p == '\\') {
+        if (*++p == '\0') {
+          return false;
+        }
+        s.push_back(*p);
+      } else if (*p == '\'') {
+        while (*++p != '\'') {
+          if (*p == '\0') {
+            return false;
+          }
+          s.push_back(*p);
+        }
+      } else if (*p == '"') {
+        while (*++p != '"') {
+          if (*p == '\0') {
+            return false;
+          } else if (*p == '\\' && (p[1] == '"' || p[1] == '\\' || p[1] == '$' || p[1] == '`')) {
+            ++p;
+          }
+          s.push_back(*p);
+        }
+      } else {
+        s.push_back(*p);
+      }
+    }
+
+    if (word) {
+      step.push_back(s);
+    }
+  }
+}
+
+/* either a JSON array of steps, or one step per line */
+static bool parse_batch(const std::string &input, std::vector<step_t> &steps, const char *prog)
+{
+  const char *p = skip_space(input.c_str());
+  size_t pos = 0, line = 0;
+
+  if (*p == '[' && *skip_space(p + 1) == '[') {
+    for (p = skip_space(p + 1); ; p = skip_space(p + 1)) {
+      step_t step;
+
+      if ((p = parse_json_step(p, step)) == NULL) {
+        std::cerr << prog << ": error `--batch': invalid JSON" << std::endl;
+        return false;
+      }
+      steps.push_back(step);
+      p = skip_space(p);
+
+      if (*p == ']') {
+        break;
+      } else if (*p != ',' || *skip_space(p + 1) != '[') {
+        std::cerr << prog << ": error `--batch': invalid JSON" << std::endl;
+        return false;
+      }
+    }
+
+    if (*skip_space(p + 1) != '\0') {
+      std::cerr << prog << ": error `--batch': trailing data after the JSON array" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  while (pos < input.size()) {
+    size_t end = input.find('\n', pos);
+    std::string s;
+    step_t step;
+    bool ok;
+
+    if (end == std::string::npos) {
+      end = input.size();
+    }
+    s = input.substr(pos, end - pos);
+    pos = end + 1;
+    ++line;
+
+    if (s.size() > 0 && s[s.size() - 1] == '\r') {
+      s.erase(s.size() - 1);
+    }
+    const char *l = skip_space(s.c_str());
+
+    if (*l == '[') {
+      ok = ((l = parse_json_step(l, step)) != NULL && *skip_space(l) == '\0');
+    } else {
+      ok = parse_shell_step(l, step);
+    }
+
+    if (!ok) {
+      std::cerr << prog << ": error `--batch': cannot parse line " << line << std::endl;
+      return false;
+    }
+
+    if (step.size() > 0) {
+      steps.push_back(step);
+    }
+  }
+
+  return true;
+}
+
+static bool read_input(const char *file, std::string &input)
+{
+  char buf[4096];
+  ssize_t n;
+  int fd = STDIN_FILENO;
+
+  if (strcmp(file, "-") != 0 && (fd = open(file, O_RDONLY|O_CLOEXEC)) == -1) {
+    perror("open()");
+    return false;
+  }
+
+  while ((n = read(fd, buf, sizeof(buf))) != 0) {
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("read()");
+      break;
+    }
+    input.append(buf, n);
+  }
+
+  if (fd != STDIN_FILENO) {
+    close(fd);
+  }
+  return (n == 0);
+}
+
+static void print_record(size_t step, int code, int fd)
+{
+  std::string out;
+  char buf[4096];
+  ssize_t n;
+
+  lseek(fd, 0, SEEK_SET);
+
+  while ((n = read(fd, buf, sizeof(buf))) > 0 || (n == -1 && errno == EINTR)) {
+    if (n > 0) {
+      out.append(buf, n);
+    }
+  }
+
+  std::cout << "{\"step\":" << step << ",\"exit\":" << code << ",\"stdout\":\"";
+
+  for (size_t i = 0; i < out.size(); ++i) {
+    unsigned char c = out[i];
+
+    switch (c) {
+      case '"':  std::cout << "\\\""; break;
+      case '\\': std::cout << "\\\\"; break;
+      case '\n': std::cout << "\\n"; break;
+      case '\t': std::cout << "\\t"; break;
+      default:
+        if (c < 0x20) {
+          char esc[8];
+          snprintf(esc, sizeof(esc), "\\u%04x", c);
+          std::cout << esc;
+        } else {
+          std::cout << c;
+        }
+        break;
+    }
+  }
+
+  std::cout << "\"}" << std::endl;
+}
+
+static int run_step(const char *prog, step_t &step, int (*run)(int, char **), int out_fd)
+{
+  std::vector<char *> args;
+  int status;
+  pid_t pid;
+
+  args.push_back(const_cast<char *>(prog));
+
+  for (size_t i = 0; i < step.size(); ++i) {
+    args.push_back(const_cast<char *>(step[i].c_str()));
+  }
+  args.push_back(NULL);
+
+  std::cout.flush();
+
+  if ((pid = fork()) == -1) {
+    perror("fork()");
+    return 1;
+  } else if (pid == 0) {
+    if (dup2(out_fd, STDOUT_FILENO) == -1) {
+      _exit(1);
+    }
+    trace_fork();
+    trace_init(args.size() - 1, args.data());
+    exit(run(args.size() - 1, args.data()));
+  }
+
+  while (waitpid(pid, &status, 0) == -1) {
+    if (errno != EINTR) {
+      perror("waitpid()");
+      return 1;
+    }
+  }
+
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+int dialog_batch(const char *prog, const char *file, bool stop_on_error, int (*run)(int, char **))
+{
+  std::vector<step_t> steps;
+  std::string input;
+  int fd, rv = 0;
+
+  if (!read_input(file, input) || !parse_batch(input, steps, prog)) {
+    return 1;
+  }
+
+  for (size_t i = 0; i < steps.size(); ++i) {
+    for (size_t j = 0; j < steps[i].size(); ++j) {
+      const std::string &arg = steps[i][j];
+
+      if (arg == "--daemon" || arg == "--batch" || arg == "--batch-stop" || arg.compare(0, 8, "--batch=") == 0) {
+        std::cerr << prog << ": error `--batch': step " << (i + 1) << ": `" << arg
+          << "' cannot be used in a batch" << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  if ((fd = create_memfd("fltk-dialog-batch", MFD_CLOEXEC)) == -1) {
+    perror("memfd_create()");
+    return 1;
+  }
+
+  preload_fonts();
+
+  for (size_t i = 0; i < steps.size(); ++i) {
+    if (ftruncate(fd, 0) == -1 || lseek(fd, 0, SEEK_SET) == -1) {
+      perror("ftruncate()");
+      rv = 1;
+      break;
+    }
+
+    rv = run_step(prog, steps[i], run, fd);
+    print_record(i + 1, rv, fd);
+
+    if (rv != 0 && stop_on_error) {
+      break;
+    }
+  }
+
+  close(fd);
+  return rv;
+}
@@ -0,0 +1,111 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include "fltk-dialog.hpp"
+#include "bench.hpp"
+
+#ifdef WITH_BENCHMARK
+
+static std::atomic<uint64_t> lines_total(0);
+static std::atomic<uint64_t> pending_since(0);  /* oldest undrawn input, 0 if none */
+static std::atomic<uint64_t> first_input(0), last_input(0);
+static uint64_t flushes = 0;
+static std::vector<uint64_t> latencies;
+static std::atomic_flag registered = ATOMIC_FLAG_INIT;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static double percentile(double p)
+{
+  if (latencies.empty()) {
+    return 0;
+  }
+  size_t i = static_cast<size_t>(p * (latencies.size() - 1) + 0.5);
+  return latencies[i] / 1e6;
+}
+
+static void bench_report(void)
+{
+  struct rusage ru;
+  uint64_t first = first_input, last = last_input;
+  double elapsed = (last > first) ? (last - first) / 1e9 : 0;
+  uint64_t lines = lines_total;
+
+  getrusage(RUSAGE_SELF, &ru);
+  std::sort(latencies.begin(), latencies.end());
+
+  fprintf(stderr,
+    "{\"lines\":%llu,\"ingest_seconds\":%.3f,\"lines_per_second\":%.0f,\"flushes\":%llu,"
+    "\"latency_ms\":{\"samples\":%zu,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f},"
+    "\"cpu_user_seconds\":%.3f,\"cpu_system_seconds\":%.3f,\"max_rss_kib\":%ld}\n",
+    static_cast<unsigned long long>(lines), elapsed, (elapsed > 0) ? lines / elapsed : 0,
+    static_cast<unsigned long long>(flushes),
+    latencies.size(), percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0),
+    ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6,
+    ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6,
+    ru.ru_maxrss);
+}
+
+void bench_input(size_t lines)
+{
+  uint64_t t = now_ns();
+  uint64_t expected = 0;
+
+  if (!registered.test_and_set()) {
+    first_input = t;
+    atexit(bench_report);
+  }
+
+  lines_total += lines;
+  last_input = t;
+  pending_since.compare_exchange_strong(expected, t);
+}
+
+void bench_window::flush()
+{
+  Fl_Double_Window::flush();
+
+  uint64_t t = pending_since.exchange(0);
+  flushes++;
+
+  if (t > 0) {
+    latencies.push_back(now_ns() - t);
+  }
+}
+
+#endif  /* WITH_BENCHMARK */
@@ -0,0 +1,59 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "fltk-dialog.hpp"
+
+/* Instrumentation for the stdin-driven dialogs, enabled by building with
+ * `make BENCHMARK=1'.  It counts ingested lines and window flushes and
+ * measures how long ingested input waits until it has been drawn.
+ * The results are printed to stderr as a JSON line when the process exits;
+ * see bench/run.sh for a driver script. */
+
+#ifdef WITH_BENCHMARK
+
+class bench_window : public Fl_Double_Window
+{
+public:
+  bench_window(int W, int H, const char *L=NULL)
+    : Fl_Double_Window(W, H, L)
+  { }
+
+  void flush();
+};
+
+/* call BEFORE the new input can become visible; may be called from any thread */
+void bench_input(size_t lines);
+
+#else
+
+typedef Fl_Double_Window bench_window;
+
+# define bench_input(lines)
+
+#endif  /* WITH_BENCHMARK */
+
+#endif  /* !BENCH_HPP */
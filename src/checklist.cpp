@@ -24,81 +24,118 @@
 
 #include <string>
 #include <iostream>
-#include <vector>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "fltk-dialog.hpp"
+#include "frame_update.hpp"
+#include "fuzzy_filter.hpp"
+#include "list_view.hpp"
 
-class checklist_browser : public Fl_Check_Browser
-{
-public:
-  checklist_browser(int X, int Y, int W, int H) : Fl_Check_Browser(X, Y, W, H) { }
+static Fl_Double_Window *win;
+static list_view *browser;
+static fuzzy_filter *filter;
+static Fl_Input *filter_input;
+static option_list *options;
+static bool check_new = false;
+static bool too_few = false;
+static int ret = 1;
 
-  /* The destructor deletes all list items and destroys the browser. */
-  ~checklist_browser() { clear(); }
+static void close_cb(Fl_Widget *, long p) {
+  win->hide();
+  ret = p;
+}
 
-protected:
-  void item_draw(void *v, int X, int Y, int, int) const
-  {
-    /* https://unicode-table.com/en/blocks/miscellaneous-symbols/ */
-    const char *u = "\u2610";  /* Ballot Box */
-    const char *c = "\u2611";  /* Ballot Box with Check */
-    //const char *c = "\u2612";  /* Ballot Box with X */
+static void filter_cb(Fl_Widget *o) {
+  Fl_Input *in = dynamic_cast<Fl_Input *>(o);
+  browser->filter(filter->query(in->value()) ? &filter->result() : NULL);
+}
 
-    cb_item *i = reinterpret_cast<cb_item *>(v);
-    int tsize = textsize();
-    Fl_Color col = active_r() ? textcolor() : fl_inactive(textcolor());
+static void frame_cb()
+{
+  size_t first = browser->size();
 
-    X += 2;
-    Y += tsize - 1;
+  if (options->sync() == 0) {
+    return;
+  }
 
-    fl_color(active_r() ? FL_FOREGROUND_COLOR : fl_inactive(FL_FOREGROUND_COLOR));
-    fl_font(FL_HELVETICA, tsize);
-    fl_draw(i->checked ? c : u, X, Y);
+  browser->grow(options->data(), options->size());
 
-    fl_font(textfont(), tsize);
-    if (i->selected) {
-      col = fl_contrast(col, selection_color());
+  if (check_new) {
+    for (size_t i = first; i < browser->size(); ++i) {
+      browser->checked(i, true);
     }
-    fl_color(col);
-    fl_draw(i->text, X + tsize + 4, Y);
   }
-};
 
-static Fl_Double_Window *win;
-static int ret = 1;
+  filter->append(options->data(), options->size());
 
-static void close_cb(Fl_Widget *, long p) {
-  win->hide();
-  ret = p;
+  if (filter->query(filter_input->value())) {
+    browser->filter(&filter->result(), true);
+  }
+}
+
+static frame_update frame(frame_cb);
+
+/* new options are shown at most once per frame */
+static void schedule_update()
+{
+  frame.request();
+}
+
+static int too_few_options()
+{
+  title = "error: checklist";
+  msg = "Two or more options required!";
+  dialog_message(MESSAGE_TYPE_INFO);
+  return 1;
 }
 
-int dialog_checklist(std::string checklist_options, bool return_value, bool check_all, char separator)
+/* the input has ended */
+static void eof_cb(void *)
+{
+  if (!win->shown()) {
+    return;
+  }
+
+  frame_cb();
+
+  if (options->size() < 2) {
+    too_few = true;
+    close_cb(NULL, 1);
+  }
+}
+
+static void *read_options(void *)
+{
+  options->read_stream(schedule_update);
+  Fl::awake(eof_cb);
+  return NULL;
+}
+
+int dialog_checklist(option_list &options_, bool return_value, bool check_all, char separator)
 {
   Fl_Group         *g, *g_inside, *buttongroup;
   Fl_Box           *dummy1, *dummy2;
   Fl_Return_Button *but_ok;
   Fl_Button        *but_cancel;
-  Fl_Check_Browser *browser;
-
-  std::vector<std::string> vec;
-  size_t vec_size;
   int range;
 
-  split(checklist_options, separator, vec);
-  vec_size = vec.size();
+  options = &options_;
+  check_new = check_all;
 
-  if (vec_size < 2) {
-    title = "error: checklist";
-    msg = "Two or more options required!";
-    dialog_message(MESSAGE_TYPE_INFO);
-    return 1;
+  if (!options->streaming() && options->size() < 2) {
+    return too_few_options();
   }
 
   if (!title) {
     title = "Select your option(s)";
   }
 
+  fuzzy_filter ff(options->data(), options->size());
+  filter = &ff;
+
   win = new Fl_Double_Window(420, 356, title);
   win->callback(close_cb, 1);
   {
@@ -106,20 +143,23 @@ int dialog_checklist(std::string checklist_options, bool return_value, bool chec
     {
       g_inside = new Fl_Group(0, 0, 420, 310);
       {
-        browser = new checklist_browser(10, 10, 400, 299);
+        filter_input = new Fl_Input(10, 10, 400, 26);
+        filter_input->tooltip("Type to filter the list");
+        filter_input->when(FL_WHEN_CHANGED);
+        filter_input->callback(filter_cb);
+
+        /* https://unicode-table.com/en/blocks/miscellaneous-symbols/ */
+        browser = new list_view(10, 42, 400, 267, list_view::CHECK);
+        browser->symbols("\u2610", "\u2611");  /* Ballot Box, Ballot Box with Check */
         browser->box(FL_THIN_DOWN_BOX);
         browser->color(fl_lighter(fl_lighter(FL_BACKGROUND_COLOR)));
         browser->clear_visible_focus();
-        for (auto it = vec.begin(); it != vec.end(); ++it) {
-          std::string &s = *it;
-          browser->add(s.c_str());
-        }
+        browser->items(options->data(), options->size());
         if (check_all) {
           browser->check_all();
         }
         dummy1 = new Fl_Box(10, 308, 400, 1);
         dummy1->box(FL_NO_BOX);
-        vec.clear();
       }
       g_inside->resizable(dummy1);
       g_inside->end();
@@ -142,15 +182,36 @@ int dialog_checklist(std::string checklist_options, bool return_value, bool chec
     buttongroup->resizable(dummy2);
     buttongroup->end();
   }
+
+  /* options from a pipe are added while the dialog is shown */
+  if (options->streaming()) {
+    pthread_t th;
+
+    Fl::lock();
+
+    int errsv = pthread_create(&th, 0, &read_options, NULL);
+
+    if (errsv != 0) {
+      errno = errsv;
+      perror("pthread_create()");
+      return 1;
+    }
+    pthread_detach(th);
+  }
+
   run_window(win, g, range, 100);
 
+  if (too_few) {
+    return too_few_options();
+  }
+
   if (ret == 0) {
     std::string list;
-    for (size_t i = 1; i <= vec_size; ++i) {
+    for (size_t i = 0; i < browser->size(); ++i) {
       if (return_value) {
         if (browser->checked(i)) {
           list.append(quote);
-          list.append(browser->text(i));
+          list.append(browser->text(i).data, browser->text(i).len);
           list.append(quote);
           list.push_back(separator);
         }
@@ -162,7 +223,9 @@ int dialog_checklist(std::string checklist_options, bool return_value, bool chec
       }
     }
     /* strip trailing separator */
-    list.pop_back();
+    if (!list.empty()) {
+      list.pop_back();
+    }
     std::cout << list << std::endl;
   }
 
@@ -0,0 +1,273 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <FL/Fl_Menu_Window.H>
+
+#include "fltk-dialog.hpp"
+#include "combo_box.hpp"
+#include "list_view.hpp"
+
+/* visible rows of the pop-up list */
+#define POPUP_ROWS  12
+#define INPUT_H     26
+#define ARROW_W     20
+
+
+namespace
+{
+  class combo_popup : public Fl_Menu_Window
+  {
+  public:
+    combo_popup(int X, int Y, int W, int H, fuzzy_filter *filter);
+
+    int handle(int event);
+
+    Fl_Input *input;
+    list_view *list;
+    fuzzy_filter *filter;
+    long picked;
+  };
+}
+
+static void input_cb(Fl_Widget *, void *v)
+{
+  combo_popup *o = reinterpret_cast<combo_popup *>(v);
+  o->list->filter(o->filter->query(o->input->value()) ? &o->filter->result() : NULL);
+}
+
+static void list_cb(Fl_Widget *, void *v)
+{
+  combo_popup *o = reinterpret_cast<combo_popup *>(v);
+  o->picked = o->list->value();
+  o->hide();
+}
+
+combo_popup::combo_popup(int X, int Y, int W, int H, fuzzy_filter *filter_)
+ : Fl_Menu_Window(X, Y, W, H),
+   filter(filter_),
+   picked(-1)
+{
+  box(FL_BORDER_BOX);
+  {
+    input = new Fl_Input(1, 1, W - 2, INPUT_H);
+    input->when(FL_WHEN_CHANGED);
+    input->callback(input_cb, this);
+
+    list = new list_view(1, INPUT_H + 1, W - 2, H - INPUT_H - 2, list_view::RADIO);
+    list->box(FL_FLAT_BOX);
+    list->clear_visible_focus();
+    list->callback(list_cb, this);
+  }
+  end();
+  set_override();
+  set_menu_window();
+}
+
+int combo_popup::handle(int event)
+{
+  switch (event) {
+    case FL_PUSH:
+      /* a click outside closes the pop-up */
+      if (!Fl::event_inside(0, 0, w(), h())) {
+        hide();
+        return 1;
+      }
+      break;
+
+    /* keys the input field didn't use */
+    case FL_KEYBOARD:
+      switch (Fl::event_key()) {
+        case FL_Escape:
+          hide();
+          return 1;
+        case FL_Enter:
+        case FL_KP_Enter:
+          picked = list->current();
+          hide();
+          return 1;
+        case FL_Up:
+        case FL_Down:
+        case FL_Page_Up:
+        case FL_Page_Down:
+          return list->handle_key(Fl::event_key());
+      }
+      break;
+  }
+
+  return Fl_Menu_Window::handle(event);
+}
+
+
+combo_box::combo_box(int X, int Y, int W, int H, const char *L)
+ : Fl_Widget(X, Y, W, H, L),
+   items_(NULL),
+   count_(0),
+   value_(-1),
+   filter_(NULL),
+   textfont_(FL_HELVETICA),
+   textsize_(FL_NORMAL_SIZE)
+{
+  box(FL_UP_BOX);
+}
+
+combo_box::~combo_box()
+{
+  delete filter_;
+}
+
+void combo_box::items(const str_view *items, size_t count)
+{
+  delete filter_;
+  filter_ = new fuzzy_filter(items, count);
+  items_ = items;
+  count_ = count;
+  value_ = (count > 0) ? 0 : -1;
+  redraw();
+}
+
+void combo_box::popup(const char *text)
+{
+  int X, Y, W, H, rows, rh;
+  int sx, sy, sw, sh;
+
+  if (count_ == 0) {
+    return;
+  }
+
+  fl_font(textfont_, textsize_);
+  rh = fl_height() + 2;
+  rows = (count_ < POPUP_ROWS) ? count_ : POPUP_ROWS;
+
+  X = window()->x_root() + x();
+  Y = window()->y_root() + y() + h();
+  W = w();
+  H = INPUT_H + rows*rh + 2;
+
+  /* open upwards if there's not enough room below */
+  Fl::screen_work_area(sx, sy, sw, sh, X, Y);
+  if (Y + H > sy + sh) {
+    Y = window()->y_root() + y() - H;
+  }
+
+  combo_popup p(X, Y, W, H, filter_);
+  p.list->textfont(textfont_);
+  p.list->textsize(textsize_);
+  p.list->empty_text(COMBO_EMPTY_TEXT);
+  p.list->items(items_, count_);
+
+  if (text && *text) {
+    p.input->value(text);
+    p.input->insert_position(p.input->size());
+    input_cb(p.input, &p);
+  } else if (value_ >= 0) {
+    p.list->show_row(value_);
+  }
+
+  p.show();
+  p.input->take_focus();
+  Fl::grab(&p);
+
+  while (p.shown()) {
+    Fl::wait();
+  }
+  Fl::grab(NULL);
+
+  if (p.picked >= 0) {
+    value_ = p.picked;
+    redraw();
+    do_callback();
+  }
+}
+
+void combo_box::draw()
+{
+  int X = x() + Fl::box_dx(box());
+  int Y = y() + Fl::box_dy(box());
+  int W = w() - Fl::box_dw(box()) - ARROW_W;
+  int H = h() - Fl::box_dh(box());
+  int ax = X + W + ARROW_W/2;
+  int ay = Y + H/2;
+  Fl_Color fg = active_r() ? FL_FOREGROUND_COLOR : fl_inactive(FL_FOREGROUND_COLOR);
+
+  draw_box();
+
+  if (value_ >= 0) {
+    const str_view &v = items_[value_];
+    int baseline;
+
+    fl_push_clip(X, Y, W, H);
+    fl_font(textfont_, textsize_);
+    fl_color(fg);
+    baseline = Y + (H - fl_height())/2 + fl_height() - fl_descent();
+
+    if (v.len == 0) {
+      fl_draw(COMBO_EMPTY_TEXT, X + 4, baseline);
+    } else {
+      fl_draw(v.data, static_cast<int>(v.len), X + 4, baseline);
+    }
+    fl_pop_clip();
+  }
+
+  fl_color(fg);
+  fl_polygon(ax - 4, ay - 2, ax + 4, ay - 2, ax, ay + 3);
+
+  draw_focus();
+}
+
+int combo_box::handle(int event)
+{
+  switch (event) {
+    case FL_FOCUS:
+    case FL_UNFOCUS:
+      if (Fl::visible_focus()) {
+        redraw();
+        return 1;
+      }
+      return 0;
+
+    case FL_PUSH:
+      if (Fl::visible_focus()) {
+        take_focus();
+      }
+      popup(NULL);
+      return 1;
+
+    case FL_KEYBOARD:
+      if (Fl::event_key() == FL_Down || Fl::event_key() == ' ') {
+        popup(NULL);
+        return 1;
+      }
+
+      /* start filtering with the typed text */
+      if (Fl::event_length() > 0 && static_cast<unsigned char>(Fl::event_text()[0]) >= ' ' &&
+          !Fl::event_ctrl() && !Fl::event_alt())
+      {
+        popup(Fl::event_text());
+        return 1;
+      }
+      break;
+  }
+
+  return 0;
+}
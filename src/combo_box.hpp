@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef COMBO_BOX_HPP
+#define COMBO_BOX_HPP
+
+#include <stddef.h>
+
+#include "fltk-dialog.hpp"
+#include "fuzzy_filter.hpp"
+
+/* shown for empty options */
+#define COMBO_EMPTY_TEXT  "<EMPTY>"
+
+
+/* A drop-down selection like Fl_Choice for very long option lists.  The
+ * pop-up shows the options in a list_view with an input field to filter
+ * them, so opening it takes the same time for any number of options.
+ * Typing while the box has the focus opens the pop-up with that text. */
+class combo_box : public Fl_Widget
+{
+public:
+  combo_box(int X, int Y, int W, int H, const char *L = NULL);
+  virtual ~combo_box();
+
+  /* the array isn't copied */
+  void items(const str_view *items, size_t count);
+  size_t size() const { return count_; }
+  const str_view &text(size_t i) const { return items_[i]; }
+
+  /* the selected item, -1 if none */
+  long value() const { return value_; }
+  void value(long v) { value_ = v; redraw(); }
+
+  Fl_Font textfont() const { return textfont_; }
+  void textfont(Fl_Font f) { textfont_ = f; }
+
+  Fl_Fontsize textsize() const { return textsize_; }
+  void textsize(Fl_Fontsize s) { textsize_ = s; }
+
+  int handle(int event);
+
+protected:
+  void draw();
+
+private:
+  const str_view *items_;
+  size_t count_;
+  long value_;
+  fuzzy_filter *filter_;
+  Fl_Font textfont_;
+  Fl_Fontsize textsize_;
+
+  void popup(const char *text);
+};
+
+#endif  /* !COMBO_BOX_HPP */
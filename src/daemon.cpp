@@ -0,0 +1,592 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// fltk-dialog --daemon &
+// time ./build/fltk_dialog/fltk-dialog --question --text="Continue?"
+// FLTK_DIALOG_NO_DAEMON=1 ./build/fltk_dialog/fltk-dialog --question --text="Continue?"
+
+/* The server is a pre-forked "zygote": it does the process-wide setup that
+ * doesn't depend on the display once (exec and dynamic linking, loading
+ * the fontconfig configuration and caches, resolving the default fonts)
+ * and forks a child for every client.  The child takes over the client's
+ * stdin/stdout/stderr, working directory and environment and runs the
+ * dialog like a normal invocation would.
+ *
+ * Everything tied to the display is still done by the child: opening the
+ * X connection, Xft/Pango font setup and the scheme.  An Xlib connection
+ * cannot be shared across fork(), and Xft and Pango keep their fonts per
+ * display.  Compare `--trace-startup' with and without a running server
+ * to see what is actually saved on a given system.
+ *
+ * Forking also means that every dialog starts with pristine global state,
+ * so none of the dialogs need to be reentrant.
+ *
+ * Protocol (all on one SOCK_STREAM connection):
+ *   client -> server: request_header + fds 0, 1, 2 (SCM_RIGHTS)
+ *   client -> server: `size' bytes: cwd, argv[], environ[], each NUL-terminated
+ *   server -> client: int32_t exit code once the dialog process has exited
+ */
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fontconfig/fontconfig.h>
+
+#include "fltk-dialog.hpp"
+#include "trace.hpp"
+
+#define REQUEST_MAGIC     0x44444446  /* "FDDD" */
+#define REQUEST_MAX_SIZE  (16 << 20)
+
+extern char **environ;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t argc;
+  uint32_t envc;
+  uint32_t size;
+} request_header;
+
+static std::string socket_path(void)
+{
+  const char *env;
+  char buf[64];
+
+  if ((env = getenv("FLTK_DIALOG_SOCKET")) && *env) {
+    return env;
+  }
+
+  if ((env = getenv("XDG_RUNTIME_DIR")) && *env) {
+    return std::string(env) + "/fltk-dialog.sock";
+  }
+
+  snprintf(buf, sizeof(buf), "/tmp/fltk-dialog-%u.sock", static_cast<unsigned int>(getuid()));
+  return buf;
+}
+
+static bool make_address(const std::string &path, struct sockaddr_un &addr)
+{
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return true;
+}
+
+static bool write_all(int fd, const char *p, size_t len)
+{
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static bool read_all(int fd, char *p, size_t len)
+{
+  while (len > 0) {
+    ssize_t n = read(fd, p, len);
+
+    if (n == -1 && errno == EINTR) {
+      continue;
+    } else if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+/* client side */
+
+static bool trusted_socket(const char *path, int fd)
+{
+  struct stat st;
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+
+  if (lstat(path, &st) == -1 || !S_ISSOCK(st.st_mode) || st.st_uid != getuid()) {
+    return false;
+  }
+
+  return (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid());
+}
+
+static void append(std::string &buf, const char *s)
+{
+  buf.append(s);
+  buf.push_back('\0');
+}
+
+bool daemon_client(int argc, char **argv, int &rv)
+{
+  struct sockaddr_un addr;
+  struct msghdr mh;
+  struct iovec iov;
+  struct cmsghdr *cm;
+  union {
+    char buf[CMSG_SPACE(3 * sizeof(int))];
+    struct cmsghdr align;
+  } ctl;
+  request_header hdr;
+  std::string payload;
+  int32_t code;
+  char *cwd;
+  int fd, envc = 0;
+  const int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+
+  if (getenv("FLTK_DIALOG_NO_DAEMON") || !make_address(socket_path(), addr)) {
+    return false;
+  }
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0)) == -1) {
+    return false;
+  }
+
+  /* no server running: fail silently and run the dialog ourself */
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+    close(fd);
+    return false;
+  }
+
+  /* The server gets our environment and file descriptors and decides the
+   * exit code, so it must be our own.  Another user could have created
+   * the socket first, i.e. in /tmp. */
+  if (!trusted_socket(addr.sun_path, fd)) {
+    std::cerr << argv[0] << ": ignoring dialog server not owned by the current user: " << addr.sun_path
+      << std::endl;
+    close(fd);
+    return false;
+  }
+
+  if ((cwd = getcwd(NULL, 0)) == NULL) {
+    close(fd);
+    return false;
+  }
+  append(payload, cwd);
+  free(cwd);
+
+  for (int i = 0; i < argc; ++i) {
+    append(payload, argv[i]);
+  }
+
+  for (char **e = environ; *e; ++e, ++envc) {
+    append(payload, *e);
+  }
+
+  hdr.magic = REQUEST_MAGIC;
+  hdr.argc = argc;
+  hdr.envc = envc;
+  hdr.size = payload.size();
+
+  iov.iov_base = &hdr;
+  iov.iov_len = sizeof(hdr);
+
+  memset(&mh, 0, sizeof(mh));
+  memset(&ctl, 0, sizeof(ctl));
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+  mh.msg_control = ctl.buf;
+  mh.msg_controllen = sizeof(ctl.buf);
+
+  cm = CMSG_FIRSTHDR(&mh);
+  cm->cmsg_level = SOL_SOCKET;
+  cm->cmsg_type = SCM_RIGHTS;
+  cm->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+  /* nothing was started yet, so falling back is still safe */
+  if (payload.size() > REQUEST_MAX_SIZE || sendmsg(fd, &mh, MSG_NOSIGNAL) != sizeof(hdr)) {
+    close(fd);
+    return false;
+  }
+
+  if (!write_all(fd, payload.data(), payload.size()) ||
+      !read_all(fd, reinterpret_cast<char *>(&code), sizeof(code)))
+  {
+    std::cerr << argv[0] << ": lost connection to the dialog server" << std::endl;
+    close(fd);
+    rv = 1;
+    return true;
+  }
+
+  close(fd);
+  rv = code;
+  return true;
+}
+
+/* server side */
+
+static int listen_fd = -1;
+static int signal_fd = -1;
+typedef struct {
+  int conn;
+  bool killed;
+} client;
+
+static std::map<pid_t, client> clients;  /* dialog process -> connection */
+
+/* child process: receive the request and become the client */
+static void run_request(int conn, const sigset_t &mask, int (*run)(int, char **))
+{
+  struct msghdr mh;
+  struct iovec iov;
+  struct cmsghdr *cm;
+  union {
+    char buf[CMSG_SPACE(3 * sizeof(int))];
+    struct cmsghdr align;
+  } ctl;
+  request_header hdr;
+  std::vector<char *> args;
+  char *payload, *p, *end;
+  int fds[3];
+  ssize_t n;
+
+  close(listen_fd);
+  close(signal_fd);
+
+  for (std::map<pid_t, client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+    close(it->second.conn);
+  }
+
+  signal(SIGPIPE, SIG_DFL);
+  sigprocmask(SIG_UNBLOCK, &mask, NULL);
+
+  iov.iov_base = &hdr;
+  iov.iov_len = sizeof(hdr);
+
+  memset(&mh, 0, sizeof(mh));
+  mh.msg_iov = &iov;
+  mh.msg_iovlen = 1;
+  mh.msg_control = ctl.buf;
+  mh.msg_controllen = sizeof(ctl.buf);
+
+  do {
+    n = recvmsg(conn, &mh, MSG_CMSG_CLOEXEC|MSG_WAITALL);
+  } while (n == -1 && errno == EINTR);
+
+  cm = CMSG_FIRSTHDR(&mh);
+
+  if (n != sizeof(hdr) || hdr.magic != REQUEST_MAGIC || hdr.size > REQUEST_MAX_SIZE || hdr.argc == 0 ||
+      !cm || cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS ||
+      cm->cmsg_len != CMSG_LEN(sizeof(fds)))
+  {
+    _exit(1);
+  }
+  memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+
+  payload = new char[hdr.size + 1];
+  payload[hdr.size] = '\0';
+
+  if (!read_all(conn, payload, hdr.size)) {
+    _exit(1);
+  }
+  close(conn);
+
+  for (int i = 0; i < 3; ++i) {
+    if (dup2(fds[i], i) == -1) {
+      _exit(1);
+    }
+    close(fds[i]);
+  }
+
+  /* split the payload; a truncated list is padded with empty strings */
+  p = payload;
+  end = payload + hdr.size;
+
+  if (chdir(p) == -1) {
+    perror("chdir()");
+  }
+  p += strlen(p) + (p < end);
+
+  for (uint32_t i = 0; i < hdr.argc; ++i) {
+    args.push_back(p);
+    p += strlen(p) + (p < end);
+  }
+  args.push_back(NULL);
+
+  clearenv();
+
+  for (uint32_t i = 0; i < hdr.envc && p < end; ++i) {
+    putenv(p);
+    p += strlen(p) + 1;
+  }
+
+  trace_fork();
+  trace_init(hdr.argc, args.data());
+
+  exit(run(hdr.argc, args.data()));
+}
+
+static void accept_client(const sigset_t &mask, int (*run)(int, char **))
+{
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+  pid_t pid;
+  int conn;
+
+  if ((conn = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC)) == -1) {
+    if (errno != EINTR && errno != EAGAIN && errno != ECONNABORTED) {
+      perror("accept4()");
+    }
+    return;
+  }
+
+  /* only serve the user who started the server */
+  if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1 || cred.uid != getuid()) {
+    close(conn);
+    return;
+  }
+
+  if ((pid = fork()) == -1) {
+    perror("fork()");
+    close(conn);
+  } else if (pid == 0) {
+    run_request(conn, mask, run);
+  } else {
+    clients[pid].conn = conn;
+    clients[pid].killed = false;
+  }
+}
+
+static void reap_children(void)
+{
+  int status;
+  pid_t pid;
+
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    std::map<pid_t, client>::iterator it = clients.find(pid);
+
+    if (it == clients.end()) {
+      continue;
+    }
+
+    int32_t code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    write_all(it->second.conn, reinterpret_cast<const char *>(&code), sizeof(code));
+    close(it->second.conn);
+    clients.erase(it);
+  }
+}
+
+/* Load the font configuration and caches and resolve the families FLTK
+ * uses by default, so that forked children inherit them.  The matched font
+ * files are read ahead into the page cache, where the children's Xft will
+ * find them. */
+void preload_fonts(void)
+{
+  const char *families[] = { "sans", "mono", "serif" };
+  uint64_t t = trace_now();
+
+  if (!FcInit()) {
+    return;
+  }
+
+  for (size_t i = 0; i < sizeof(families)/sizeof(*families); ++i) {
+    FcPattern *pat = FcNameParse(reinterpret_cast<const FcChar8 *>(families[i]));
+    FcPattern *match;
+    FcChar8 *file;
+    FcResult res;
+
+    if (!pat) {
+      continue;
+    }
+
+    FcConfigSubstitute(NULL, pat, FcMatchPattern);
+    FcDefaultSubstitute(pat);
+
+    if ((match = FcFontMatch(NULL, pat, &res)) != NULL) {
+      if (FcPatternGetString(match, FC_FILE, 0, &file) == FcResultMatch) {
+        int fd = open(reinterpret_cast<const char *>(file), O_RDONLY|O_CLOEXEC);
+
+        if (fd != -1) {
+          posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+          close(fd);
+        }
+      }
+      FcPatternDestroy(match);
+    }
+    FcPatternDestroy(pat);
+  }
+
+  trace_span("preload fonts", t);
+}
+
+int daemon_main(const char *prog, int (*run)(int, char **))
+{
+  struct sockaddr_un addr;
+  struct signalfd_siginfo si;
+  std::vector<struct pollfd> pfd;
+  std::string path = socket_path();
+  sigset_t mask;
+  int fd;
+
+  if (!make_address(path, addr)) {
+    std::cerr << prog << ": socket path too long: " << path << std::endl;
+    return 1;
+  }
+
+  /* refuse to replace a running server, but remove a stale socket */
+  if ((fd = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0)) == -1) {
+    perror("socket()");
+    return 1;
+  }
+
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0) {
+    std::cerr << prog << ": a dialog server is already listening on " << path << std::endl;
+    close(fd);
+    return 1;
+  }
+  close(fd);
+  unlink(path.c_str());
+
+  if ((listen_fd = socket(AF_UNIX, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0)) == -1) {
+    perror("socket()");
+    return 1;
+  }
+
+  mode_t old_umask = umask(0077);
+
+  if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+    perror("bind()");
+    umask(old_umask);
+    close(listen_fd);
+    return 1;
+  }
+  umask(old_umask);
+
+  if (listen(listen_fd, SOMAXCONN) == -1) {
+    perror("listen()");
+    unlink(path.c_str());
+    close(listen_fd);
+    return 1;
+  }
+
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  sigaddset(&mask, SIGHUP);
+  sigprocmask(SIG_BLOCK, &mask, NULL);
+
+  if ((signal_fd = signalfd(-1, &mask, SFD_NONBLOCK|SFD_CLOEXEC)) == -1) {
+    perror("signalfd()");
+    unlink(path.c_str());
+    close(listen_fd);
+    return 1;
+  }
+
+  /* a client may disappear before we send its exit code */
+  signal(SIGPIPE, SIG_IGN);
+
+  preload_fonts();
+
+  for (;;) {
+    pfd.clear();
+    pfd.push_back({ listen_fd, POLLIN, 0 });
+    pfd.push_back({ signal_fd, POLLIN, 0 });
+
+    /* the client went away (i.e. it was killed): close its dialog */
+    for (std::map<pid_t, client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+      if (!it->second.killed) {
+        pfd.push_back({ it->second.conn, POLLRDHUP, 0 });
+      }
+    }
+
+    if (poll(pfd.data(), pfd.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll()");
+      break;
+    }
+
+    if (pfd[1].revents & POLLIN) {
+      bool quit = false;
+
+      while (read(signal_fd, &si, sizeof(si)) == sizeof(si)) {
+        if (si.ssi_signo != SIGCHLD) {
+          quit = true;
+        }
+      }
+      reap_children();
+
+      if (quit) {
+        break;
+      }
+    }
+
+    for (size_t i = 2; i < pfd.size(); ++i) {
+      if (pfd[i].revents & (POLLRDHUP|POLLHUP|POLLERR)) {
+        for (std::map<pid_t, client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+          if (it->second.conn == pfd[i].fd) {
+            kill(it->first, SIGTERM);
+            it->second.killed = true;
+            break;
+          }
+        }
+      }
+    }
+
+    if (pfd[0].revents & POLLIN) {
+      accept_client(mask, run);
+    }
+  }
+
+  unlink(path.c_str());
+  close(listen_fd);
+  close(signal_fd);
+
+  for (std::map<pid_t, client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+    kill(it->first, SIGTERM);
+    close(it->second.conn);
+  }
+
+  return 0;
+}
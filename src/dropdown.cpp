@@ -24,10 +24,10 @@
 
 #include <iostream>
 #include <string>
-#include <vector>
 #include <stdlib.h>
 
 #include "fltk-dialog.hpp"
+#include "combo_box.hpp"
 
 static Fl_Double_Window *win;
 static int ret = 1;
@@ -37,20 +37,15 @@ static void close_cb(Fl_Widget *, long p) {
   ret = p;
 }
 
-int dialog_dropdown(std::string dropdown_list, bool return_number, char separator)
+int dialog_dropdown(option_list &options, bool return_number)
 {
   Fl_Group         *g;
-  Fl_Choice        *entries;
+  combo_box        *entries;
   Fl_Box           *dummy;
   Fl_Return_Button *but_ok;
   Fl_Button        *but_cancel;
-
-  Fl_Menu_Item *menu_items;
   int range;
 
-  std::vector<std::string> vec;
-  size_t vec_size;
-
   if (!msg) {
     msg = "Select an option";
   }
@@ -59,34 +54,26 @@ int dialog_dropdown(std::string dropdown_list, bool return_number, char separato
     title = "FLTK dropdown menu dialog";
   }
 
-  split(dropdown_list, separator, vec);
-  vec_size = vec.size();
+  /* the pop-up needs all options */
+  if (options.streaming()) {
+    options.read_stream(NULL);
+    options.sync();
+  }
 
-  if (vec_size < 2) {
+  if (options.size() < 2) {
     msg = "ERROR: need at least 2 entries";
     dialog_message(MESSAGE_TYPE_INFO);
     return 1;
   }
 
-  menu_items = new Fl_Menu_Item[vec_size + 1];
-
-  for (size_t i = 0; i < vec_size; ++i) {
-    menu_items[i] = { 0,0,0,0,0, FL_NORMAL_LABEL, 0, 14, 0 };
-    menu_items[i].text = (vec.at(i) == "") ? "<EMPTY>" : vec.at(i).c_str();
-  }
-
-  menu_items[vec_size] = { 0,0,0,0,0,0,0,0,0 };
-  vec.clear();
-
   win = new Fl_Double_Window(320, 110, title);
   win->callback(close_cb, 1);
   {
     g = new Fl_Group(0, 0, 320, 110);
     {
-      entries = new Fl_Choice(10, 30, 300, 30, msg);
-      entries->down_box(FL_BORDER_BOX);
+      entries = new combo_box(10, 30, 300, 30, msg);
       entries->align(FL_ALIGN_TOP_LEFT);
-      entries->menu(menu_items);
+      entries->items(options.data(), options.size());
 
       int but_w = measure_button_width(fl_cancel, 20);
       range = but_w + 60;
@@ -106,16 +93,20 @@ int dialog_dropdown(std::string dropdown_list, bool return_number, char separato
   run_window(win, g, range, win->h());
 
   if (ret == 0) {
-    int n = entries->value();
+    long n = entries->value();
     if (return_number) {
       std::cout << quote << n + 1 << quote << std::endl;
     } else {
-      std::cout << quote << menu_items[n].text << quote << std::endl;
+      const str_view &v = entries->text(n);
+      std::cout << quote;
+      if (v.len == 0) {
+        std::cout << COMBO_EMPTY_TEXT;
+      } else {
+        std::cout.write(v.data, v.len);
+      }
+      std::cout << quote << std::endl;
     }
   }
 
-  delete[] menu_items;
-
   return ret;
 }
-
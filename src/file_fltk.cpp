@@ -41,7 +41,7 @@
 #include <unistd.h>
 
 #include "fltk-dialog.hpp"
-#include "icons.h"
+#include "icons_rgba.h"
 
 class My_Hold_Browser : public Fl_Hold_Browser
 {
@@ -107,24 +107,32 @@ static void mount_timeout(void);
 static double mount_timeout_limit = 0;
 static Fl_Timeout_Handler hmount = reinterpret_cast<Fl_Timeout_Handler>(mount_timeout);
 
-#define PNG(x)  static Fl_PNG_Image x(NULL, icons_##x##_png, icons_##x##_png_len);
-PNG(eye)
-PNG(eye_closed)
-PNG(go_up)
-PNG(go_up_gray)
-PNG(go_back)
-PNG(go_back_gray)
-PNG(icon_any)
-PNG(icon_hdd)
-PNG(icon_rom)
-PNG(icon_plugged)
-PNG(icon_dir)
-PNG(icon_desktop)
-PNG(icon_home)
-PNG(icon_link_any)
-PNG(icon_link_dir)
-PNG(list_ordered_1)
-PNG(list_ordered_2)
+/* the pixels are decoded at build time; the images are created on first use */
+#define ICON(x) \
+  static Fl_RGB_Image *x(void) { \
+    static Fl_RGB_Image *img = NULL; \
+    if (!img) { \
+      img = rgba_image(icons_##x##_rgba); \
+    } \
+    return img; \
+  }
+ICON(eye)
+ICON(eye_closed)
+ICON(go_up)
+ICON(go_up_gray)
+ICON(go_back)
+ICON(go_back_gray)
+ICON(icon_any)
+ICON(icon_hdd)
+ICON(icon_rom)
+ICON(icon_plugged)
+ICON(icon_dir)
+ICON(icon_desktop)
+ICON(icon_home)
+ICON(icon_link_any)
+ICON(icon_link_dir)
+ICON(list_ordered_1)
+ICON(list_ordered_2)
 
 
 void My_Hold_Browser::add_labelline(const char *l)
@@ -327,11 +335,11 @@ static void get_partitions(void)
     sidebar_last_device = sidebar->size();
 
     if (p.rom) {
-      sidebar->icon(sidebar->size(), &icon_rom);
+      sidebar->icon(sidebar->size(), icon_rom());
     } else if (p.hotplug) {
-      sidebar->icon(sidebar->size(), &icon_plugged);
+      sidebar->icon(sidebar->size(), icon_plugged());
     } else {
-      sidebar->icon(sidebar->size(), &icon_hdd);
+      sidebar->icon(sidebar->size(), icon_hdd());
     }
     //tooltip => p.dev ??
 
@@ -453,7 +461,7 @@ static void get_gtk3_bookmarks(void)
     int m = measure_button_width(p, SIDEBAR_EXTRA_W);
 
     sidebar->add(p, STR2VP(s.c_str()));
-    sidebar->icon(sidebar->size(), &icon_dir);
+    sidebar->icon(sidebar->size(), icon_dir());
 
     if (m > sbW) {
       sbW = m;
@@ -593,7 +601,7 @@ static void xdg_user_dir_lookup(void)
   if (!desktop.empty()) {
     desktop.push_back('/');
     sidebar->add("Desktop", STR2VP(desktop.c_str()));
-    sidebar->icon(sidebar->size(), &icon_desktop);
+    sidebar->icon(sidebar->size(), icon_desktop());
   }
 
   std::sort(xdg_dirs.begin(), xdg_dirs.end(), ignorecasesort);
@@ -607,7 +615,7 @@ static void xdg_user_dir_lookup(void)
 
     s.push_back('/');
     sidebar->add(p, STR2VP(s.c_str()));
-    sidebar->icon(sidebar->size(), &icon_dir);
+    sidebar->icon(sidebar->size(), icon_dir());
 
     if (m > sbW) {
       sbW = m;
@@ -695,12 +703,12 @@ static void fileInfo(const char *file)
 
   auto icon = br->icon(selection);
 
-  if (icon == &icon_dir || icon == &icon_link_dir) {
+  if (icon == icon_dir() || icon == icon_link_dir()) {
     infobox->label("directory");
     return;
   }
 
-  if (icon == &icon_link_any && (resolved = realpath(file, NULL)) == NULL) {
+  if (icon == icon_link_any() && (resolved = realpath(file, NULL)) == NULL) {
     /* get actual link size */
     lstat(file, &st);
     type = (st.st_size == 0) ? "empty" : "broken symbolic link";
@@ -813,10 +821,10 @@ static void hidden_callback(Fl_Widget *o)
 
   if (show_dotfiles) {
     show_dotfiles = false;
-    b->image(eye_closed);
+    b->image(eye_closed());
   } else {
     show_dotfiles = true;
-    b->image(eye);
+    b->image(eye());
   }
 
   br_change_dir();
@@ -828,10 +836,10 @@ static void sort_callback(Fl_Widget *o)
 
   if (sort_reverse) {
     sort_reverse = false;
-    b->image(list_ordered_1);
+    b->image(list_ordered_1());
   } else {
     sort_reverse = true;
-    b->image(list_ordered_2);
+    b->image(list_ordered_2());
   }
 
   br_change_dir();
@@ -884,7 +892,7 @@ static void br_callback(Fl_Widget *o)
 {
   auto icon = br->icon(br->value());
 
-  if (br->value() == 0 || (!list_files && icon != &icon_dir && icon != &icon_link_dir)) {
+  if (br->value() == 0 || (!list_files && icon != icon_dir() && icon != icon_link_dir())) {
     Fl::remove_timeout(htimeout);
     selection = 0;
     input->value("");
@@ -921,7 +929,7 @@ static void br_callback(Fl_Widget *o)
     if (br->value() == selection) {
       selection = 0;
 
-      if (icon == &icon_dir || icon == &icon_link_dir) {
+      if (icon == icon_dir() || icon == icon_link_dir()) {
         /* double-clicked on directory */
         if (access_dir(path.c_str())) {
           prev_dir = current_dir;
@@ -1043,7 +1051,7 @@ static void br_change_dir(void)
       lstat(path.c_str(), &st);
 
       br->add(entry.c_str());
-      br->icon(br->size(), S_ISLNK(st.st_mode) ? &icon_link_dir : &icon_dir);
+      br->icon(br->size(), S_ISLNK(st.st_mode) ? icon_link_dir() : icon_dir());
 
       name[0] = 0;
     }
@@ -1075,7 +1083,7 @@ static void br_change_dir(void)
       lstat(path.c_str(), &st);
 
       br->add(entry.c_str());
-      br->icon(br->size(), S_ISLNK(st.st_mode) ? &icon_link_any : &icon_any);
+      br->icon(br->size(), S_ISLNK(st.st_mode) ? icon_link_any() : icon_any());
     }
 
     fl_filename_free_list(&list, n);
@@ -1084,7 +1092,7 @@ static void br_change_dir(void)
   if (current_dir == "/") {
     addrline->label(" /");
     bt_up->deactivate();
-    bt_up->image(go_up_gray);
+    bt_up->image(go_up_gray());
   } else {
     std::string s = " " + current_dir;
 
@@ -1093,15 +1101,15 @@ static void br_change_dir(void)
     }
     addrline->copy_label(s.c_str());
     bt_up->activate();
-    bt_up->image(go_up);
+    bt_up->image(go_up());
   }
 
   if (prev_dir.empty()) {
     bt_popd->deactivate();
-    bt_popd->image(go_back_gray);
+    bt_popd->image(go_back_gray());
   } else {
     bt_popd->activate();
-    bt_popd->image(go_back);
+    bt_popd->image(go_back());
   }
 
   if (infobox) {
@@ -1176,27 +1184,27 @@ void file_chooser_fltk::create_window(int mode)
 
         bt_popd = new Fl_Button(w - bt_w*4 - 10, 5, bt_w, 30);
         bt_popd->tooltip("Previous Directory");
-        bt_popd->image(go_back_gray);
+        bt_popd->image(go_back_gray());
         bt_popd->deactivate();
         bt_popd->callback(popd_callback);
         bt_popd->clear_visible_focus();
 
         bt_up = new Fl_Button(w - bt_w*3 - 10, 5, bt_w, 30);
         bt_up->tooltip("Parent Directory");
-        bt_up->image(go_up_gray);
+        bt_up->image(go_up_gray());
         bt_up->deactivate();
         bt_up->callback(up_callback);
         bt_up->clear_visible_focus();
 
        { Fl_Button *o = new Fl_Button(w - bt_w*2 - 10, 5, bt_w, 30);
         o->tooltip("Sort Order");
-        o->image(list_ordered_1);
+        o->image(list_ordered_1());
         o->callback(sort_callback);
         o->clear_visible_focus(); }
 
        { Fl_Button *o = new Fl_Button(w - bt_w - 10, 5, bt_w, 30);
         o->tooltip("Toggle Hidden Files/Directories");
-        o->image(eye_closed);
+        o->image(eye_closed());
         o->callback(hidden_callback);
         o->clear_visible_focus(); }
       }
@@ -1217,9 +1225,9 @@ void file_chooser_fltk::create_window(int mode)
 
           sidebar->add_labelline("Places");
           sidebar->add("/", STR2VP("/"));
-          sidebar->icon(sidebar->size(), &icon_hdd);
+          sidebar->icon(sidebar->size(), icon_hdd());
           sidebar->add("Home", STR2VP(home_dir.c_str()));
-          sidebar->icon(sidebar->size(), &icon_home);
+          sidebar->icon(sidebar->size(), icon_home());
 
           /* file browser */
           br = new Fl_Hold_Browser(10 + sidebar->w(), g_top->h(), tile->w() - sidebar->w(), h - g_top->h() - 76);
@@ -59,6 +59,7 @@
 #include <FL/Fl_Preferences.H>
 #include <FL/Fl_Progress.H>
 #include <FL/Fl_Return_Button.H>
+#include <FL/Fl_Scrollbar.H>
 #include <FL/Fl_Single_Window.H>
 #include <FL/Fl_Slider.H>
 #include <FL/Fl_Spinner.H>
@@ -82,6 +83,16 @@
 
 #include <string>
 #include <vector>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "option_list.hpp"
+
+/* glibc < 2.27 */
+#ifndef MFD_CLOEXEC
+# define MFD_CLOEXEC        0x0001U
+# define MFD_ALLOW_SEALING  0x0002U
+#endif
 
 #define XSTRINGIFY(x)  STRINGIFY(x)
 #define STRINGIFY(x)   #x
@@ -122,6 +133,7 @@ enum {
   DIALOG_HTML,
   DIALOG_INDICATOR,
   DIALOG_INPUT,
+  DIALOG_LIST,
   DIALOG_MESSAGE,
   DIALOG_NOTIFY,
   DIALOG_PASSWORD,
@@ -170,6 +182,12 @@ enum {
   LANG_COUNT
 };
 
+/* pixels of an image that was decoded at build time by png2rgba.py */
+typedef struct {
+  const unsigned char *pixels;
+  int w, h, d;
+} rgba_data;
+
 extern const char *title, *msg, *quote;
 extern bool resizable, window_taskbar, window_decoration, always_on_top;
 extern int override_x, override_y, override_w, override_h, override_pos;
@@ -199,12 +217,20 @@ char *format_date(const char *format, int y, int m, int d);
 size_t strlastcasecmp(const char *s1, const char *s2);
 std::string get_random(void);
 bool save_to_temp(const unsigned char *data, const unsigned int data_len, const char *postfix, std::string &path);
+int save_to_memfd(const unsigned char *data, const unsigned int data_len, const char *name, std::string &path);
+int create_memfd(const char *name, unsigned int flags);
 int leap_year(int year);
+Fl_RGB_Image *rgba_image(const rgba_data &data);
 
 #ifdef HAVE_QT
 void *dlopen_qtplugin(std::string &plugin, void * &handle, const char *func);
 #endif
 
+int daemon_main(const char *prog, int (*run)(int, char **));
+bool daemon_client(int argc, char **argv, int &rv);
+void preload_fonts(void);
+int dialog_batch(const char *prog, const char *file, bool stop_on_error, int (*run)(int, char **));
+
 int dialog_message(int type = MESSAGE_TYPE_WARNING
 ,                  bool with_icon_box = true
 ,                  const char *label_but_alt = NULL
@@ -215,19 +241,23 @@ int dialog_message(int type = MESSAGE_TYPE_WARNING
 
 int about(void);
 int dialog_calendar(const char *format);
-int dialog_checklist(std::string checklist_options, bool return_value, bool check_all, char separator);
+int dialog_checklist(option_list &options, bool return_value, bool check_all, char separator);
 int dialog_color(void);
 int dialog_date(const char *format);
 int dialog_dnd(void);
-int dialog_dropdown(std::string dropdown_list, bool return_number, char separator);
+int dialog_dropdown(option_list &options, bool return_number);
 int dialog_file_chooser(int mode, int native, bool classic, bool check_devices);
 int dialog_font(void);
 int dialog_html_viewer(const char *file);
 int dialog_indicator(const char *command, const char *indicator_icon, int native, const char *named_pipe, bool auto_close);
+int dialog_list(const std::vector<std::string> &columns, const std::vector<std::string> &cells, bool multiple,
+                int print_column, bool csv, char separator);
 int dialog_notify(const char *appname, int timeout, const char *notify_icon, bool libnotify);
-int dialog_progress(bool pulsate, unsigned int multi, long kill_pid, bool autoclose, bool hide_cancel);
-int dialog_textinfo(bool autoscroll, const char *checkbox, bool autoclose, bool hide_cancel);
-int dialog_radiolist(std::string radiolist_options, bool return_number, char separator);
+int dialog_progress(bool pulsate, unsigned int multi, long kill_pid, int watch_fd, bool autoclose, bool hide_cancel,
+                    const char *listen, const char *shm_name, bool pipe_mode, uint64_t pipe_size);
+int dialog_textinfo(bool autoscroll, const char *checkbox, bool autoclose, bool hide_cancel, const char *filename,
+                    bool follow, size_t max_lines, size_t max_bytes);
+int dialog_radiolist(option_list &options, bool return_number);
 
 char *file_chooser(int mode, bool without_gio);
 Fl_RGB_Image *img_to_rgb(const char *file);
@@ -0,0 +1,53 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FRAME_UPDATE_HPP
+#define FRAME_UPDATE_HPP
+
+#include <atomic>
+
+
+/* Shows data that other threads add at most once per frame: request()
+ * can be called any number of times on any thread and the callback then
+ * runs once on the main thread after a frame interval.  Fl::lock() must
+ * have been called before the first request. */
+class frame_update
+{
+public:
+  explicit frame_update(void (*cb)())
+   : cb_(cb),
+     pending_(false)
+  { }
+
+  void request();
+
+private:
+  void (*cb_)();
+  std::atomic<bool> pending_;
+
+  static void schedule_cb(void *v);
+  static void frame_cb(void *v);
+};
+
+#endif  /* !FRAME_UPDATE_HPP */
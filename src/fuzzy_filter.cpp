@@ -0,0 +1,381 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <queue>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "fuzzy_filter.hpp"
+
+/* fewer items than this aren't worth another thread */
+#define MIN_ITEMS_PER_THREAD  8192
+#define MAX_THREADS           16
+
+#define SCORE_MATCH        16
+#define SCORE_GAP_START    -3
+#define SCORE_GAP_EXTEND   -1
+#define BONUS_BOUNDARY     8
+#define BONUS_CAMEL        7
+#define BONUS_CONSECUTIVE  4
+
+
+namespace
+{
+  struct match
+  {
+    int score;
+    uint32_t len;
+    uint32_t item;
+  };
+
+  /* best score first, then shorter items, then in item order */
+  struct match_before
+  {
+    bool operator()(const match &a, const match &b) const {
+      if (a.score != b.score) {
+        return a.score > b.score;
+      }
+      return (a.len != b.len) ? a.len < b.len : a.item < b.item;
+    }
+  };
+
+  struct job
+  {
+    const str_view *items;
+    const uint32_t *candidates;  /* NULL for all items */
+    size_t begin, end;
+    const std::string *query;
+    bool ignore_case;
+    std::vector<uint32_t> matches;
+    std::vector<match> ranked;
+    pthread_t thread;
+    bool started;
+  };
+
+  /* position in the ranked list of a job, for the merge */
+  struct cursor
+  {
+    match m;
+    size_t job, pos;
+  };
+
+  struct cursor_after
+  {
+    bool operator()(const cursor &a, const cursor &b) const {
+      return match_before()(b.m, a.m);
+    }
+  };
+}
+
+static inline unsigned char fold(unsigned char c, bool ignore_case)
+{
+  return (ignore_case && c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static inline bool is_alnum(unsigned char c)
+{
+  /* treat UTF-8 sequences as letters */
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+static inline int bonus(const unsigned char *s, size_t i)
+{
+  if (i == 0 || !is_alnum(s[i - 1])) {
+    return BONUS_BOUNDARY;
+  }
+
+  unsigned char prev = s[i - 1];
+  unsigned char c = s[i];
+
+  if ((prev >= 'a' && prev <= 'z' && c >= 'A' && c <= 'Z') ||
+      (!(prev >= '0' && prev <= '9') && c >= '0' && c <= '9'))
+  {
+    return BONUS_CAMEL;
+  }
+  return 0;
+}
+
+int fuzzy_filter::score(const char *str, size_t len, const char *qstr, size_t qlen, bool ignore_case)
+{
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(str);
+  const unsigned char *q = reinterpret_cast<const unsigned char *>(qstr);
+  size_t start, end = 0, i, qi = 0;
+  int sc = 0;
+  bool in_gap = false, consecutive = false;
+
+  if (qlen == 0) {
+    return 0;
+  }
+
+  /* find the first occurrence of the whole subsequence ... */
+  for (i = 0; i < len; ++i) {
+    if (fold(s[i], ignore_case) == fold(q[qi], ignore_case) && ++qi == qlen) {
+      end = i + 1;
+      break;
+    }
+  }
+
+  if (qi < qlen) {
+    return -1;
+  }
+
+  /* ... and the shortest match ending there */
+  for (start = end; start > 0; ) {
+    --start;
+    if (fold(s[start], ignore_case) == fold(q[qi - 1], ignore_case) && --qi == 0) {
+      break;
+    }
+  }
+
+  for (i = start; i < end; ++i) {
+    if (qi < qlen && fold(s[i], ignore_case) == fold(q[qi], ignore_case)) {
+      int b = bonus(s, i);
+
+      /* the first character counts twice */
+      sc += SCORE_MATCH + ((qi == 0) ? 2*b : b);
+
+      if (consecutive) {
+        sc += BONUS_CONSECUTIVE;
+      }
+      consecutive = true;
+      in_gap = false;
+      ++qi;
+    } else {
+      sc += in_gap ? SCORE_GAP_EXTEND : SCORE_GAP_START;
+      consecutive = false;
+      in_gap = true;
+    }
+  }
+
+  return (sc < 0) ? 0 : sc;
+}
+
+static void *score_items(void *v)
+{
+  job *j = reinterpret_cast<job *>(v);
+  const char *q = j->query->data();
+  size_t qlen = j->query->size();
+
+  for (size_t k = j->begin; k < j->end; ++k) {
+    uint32_t n = j->candidates ? j->candidates[k] : k;
+    const str_view &item = j->items[n];
+    int sc = fuzzy_filter::score(item.data, item.len, q, qlen, j->ignore_case);
+
+    if (sc >= 0) {
+      match m = { sc, static_cast<uint32_t>(item.len), n };
+      j->matches.push_back(n);
+      j->ranked.push_back(m);
+    }
+  }
+
+  std::sort(j->ranked.begin(), j->ranked.end(), match_before());
+  return NULL;
+}
+
+fuzzy_filter::fuzzy_filter(const str_view *items, size_t count)
+ : items_(items),
+   count_(count)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  threads_ = (n < 1) ? 1 : (n > MAX_THREADS) ? MAX_THREADS : n;
+}
+
+void fuzzy_filter::items(const str_view *items, size_t count)
+{
+  items_ = items;
+  count_ = count;
+  levels_.clear();
+}
+
+bool fuzzy_filter::query(const char *q)
+{
+  std::string s = q;
+
+  if (s.empty()) {
+    return false;
+  }
+
+  /* go back to the last query that is a prefix of this one */
+  while (!levels_.empty() && s.compare(0, levels_.back().query.size(), levels_.back().query) != 0) {
+    levels_.pop_back();
+  }
+
+  if (!levels_.empty() && levels_.back().query == s) {
+    return true;
+  }
+
+  const std::vector<uint32_t> *candidates = levels_.empty() ? NULL : &levels_.back().matches;
+
+  levels_.push_back(level());
+  run(s, candidates, 0, levels_.back());
+  return true;
+}
+
+void fuzzy_filter::append(const str_view *items, size_t count)
+{
+  size_t first = count_;
+  std::vector<uint32_t> added;
+
+  if (count < first) {
+    this->items(items, count);
+    return;
+  }
+
+  items_ = items;
+  count_ = count;
+
+  if (count == first) {
+    return;
+  }
+
+  /* each level only needs the new items that matched the level before */
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    level fresh;
+    run(levels_[i].query, (i == 0) ? NULL : &added, (i == 0) ? first : 0, fresh);
+    merge(levels_[i], fresh);
+    added.swap(fresh.matches);
+  }
+}
+
+void fuzzy_filter::merge(level &to, const level &from) const
+{
+  std::vector<uint32_t> ranked;
+  std::vector<int> scores;
+  size_t a = 0, b = 0;
+
+  /* the new items come after all others in item order */
+  to.matches.insert(to.matches.end(), from.matches.begin(), from.matches.end());
+
+  ranked.reserve(to.ranked.size() + from.ranked.size());
+  scores.reserve(ranked.capacity());
+
+  while (a < to.ranked.size() || b < from.ranked.size()) {
+    bool take_from = (a == to.ranked.size());
+
+    if (!take_from && b < from.ranked.size()) {
+      match ma = { to.scores[a], static_cast<uint32_t>(items_[to.ranked[a]].len), to.ranked[a] };
+      match mb = { from.scores[b], static_cast<uint32_t>(items_[from.ranked[b]].len), from.ranked[b] };
+      take_from = match_before()(mb, ma);
+    }
+
+    if (take_from) {
+      ranked.push_back(from.ranked[b]);
+      scores.push_back(from.scores[b++]);
+    } else {
+      ranked.push_back(to.ranked[a]);
+      scores.push_back(to.scores[a++]);
+    }
+  }
+
+  to.ranked.swap(ranked);
+  to.scores.swap(scores);
+}
+
+void fuzzy_filter::run(const std::string &q, const std::vector<uint32_t> *candidates, size_t first, level &out)
+{
+  size_t total = (candidates ? candidates->size() : count_) - first;
+  size_t n = (total + MIN_ITEMS_PER_THREAD - 1) / MIN_ITEMS_PER_THREAD;
+  bool ignore_case = true;
+  std::vector<job> jobs;
+
+  /* smart case */
+  for (size_t i = 0; i < q.size(); ++i) {
+    if (q[i] >= 'A' && q[i] <= 'Z') {
+      ignore_case = false;
+      break;
+    }
+  }
+
+  if (n > threads_) {
+    n = threads_;
+  } else if (n == 0) {
+    n = 1;
+  }
+
+  jobs.resize(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    job &j = jobs[i];
+    j.items = items_;
+    j.candidates = (candidates && !candidates->empty()) ? &(*candidates)[0] : NULL;
+    j.begin = first + total * i / n;
+    j.end = first + total * (i + 1) / n;
+    j.query = &q;
+    j.ignore_case = ignore_case;
+    j.started = false;
+
+    if (candidates && candidates->empty()) {
+      j.end = j.begin;
+    }
+  }
+
+  /* the first range is scored on this thread */
+  for (size_t i = 1; i < n; ++i) {
+    jobs[i].started = (pthread_create(&jobs[i].thread, NULL, score_items, &jobs[i]) == 0);
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    if (jobs[i].started) {
+      pthread_join(jobs[i].thread, NULL);
+    } else {
+      score_items(&jobs[i]);
+    }
+  }
+
+  /* the ranges are in item order, so the matches only need to be joined;
+   * the ranked lists are merged */
+  std::priority_queue<cursor, std::vector<cursor>, cursor_after> heap;
+  size_t matches = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    matches += jobs[i].matches.size();
+
+    if (!jobs[i].ranked.empty()) {
+      cursor c = { jobs[i].ranked[0], i, 0 };
+      heap.push(c);
+    }
+  }
+
+  out.query = q;
+  out.matches.reserve(matches);
+  out.ranked.reserve(matches);
+  out.scores.reserve(matches);
+
+  for (size_t i = 0; i < n; ++i) {
+    out.matches.insert(out.matches.end(), jobs[i].matches.begin(), jobs[i].matches.end());
+  }
+
+  while (!heap.empty()) {
+    cursor c = heap.top();
+    heap.pop();
+    out.ranked.push_back(c.m.item);
+    out.scores.push_back(c.m.score);
+
+    if (++c.pos < jobs[c.job].ranked.size()) {
+      c.m = jobs[c.job].ranked[c.pos];
+      heap.push(c);
+    }
+  }
+}
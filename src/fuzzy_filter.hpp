@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FUZZY_FILTER_HPP
+#define FUZZY_FILTER_HPP
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "option_list.hpp"
+
+
+/* Filters a list of options with an fzf-like fuzzy match: the query
+ * characters must appear in the option in the same order, and matches at
+ * word starts and consecutive matches score higher.  The query is
+ * case-insensitive unless it contains upper case letters.  Equal scores
+ * are ranked shorter option first.
+ *
+ * Scoring is split across all cores and the sorted results of each thread
+ * are merged.  When the query is extended only the options that matched
+ * the previous query are scored again, and going back (Backspace) reuses
+ * the earlier results.  Items appended to a growing list are scored once
+ * for every cached query and merged into its results. */
+class fuzzy_filter
+{
+public:
+  fuzzy_filter(const str_view *items, size_t count);
+
+  /* replaces the items and forgets all results */
+  void items(const str_view *items, size_t count);
+
+  /* like items(), but the first items are the same as before and only
+   * the new ones are scored */
+  void append(const str_view *items, size_t count);
+
+  /* Returns false if q is empty, which means no filtering.  Otherwise
+   * result() holds the matching item numbers, best match first, until
+   * the next call. */
+  bool query(const char *q);
+
+  const std::vector<uint32_t> &result() const { return levels_.back().ranked; }
+
+  /* returns a negative value if q doesn't match s */
+  static int score(const char *s, size_t len, const char *q, size_t qlen, bool ignore_case);
+
+private:
+  struct level {
+    std::string query;
+    std::vector<uint32_t> matches;  /* in item order */
+    std::vector<uint32_t> ranked;   /* best match first */
+    std::vector<int> scores;        /* of the ranked items */
+  };
+
+  const str_view *items_;
+  size_t count_;
+  unsigned int threads_;
+  std::deque<level> levels_;  /* one per extension of the query */
+
+  /* scores the items from first on, or the candidates from first on */
+  void run(const std::string &q, const std::vector<uint32_t> *candidates, size_t first, level &out);
+  void merge(level &to, const level &from) const;
+};
+
+#endif  /* !FUZZY_FILTER_HPP */
@@ -31,6 +31,7 @@
 //}
 
 #include "fltk-dialog.hpp"
+#include "trace.hpp"
 #include "icns_image.hpp"
 
 
@@ -83,7 +84,7 @@ icns_image::icns_image(const char *filename) : Fl_RGB_Image(0,0,0)
 
   /* dlopen() libicns */
 
-  void *handle = dlopen("libicns.so.1", RTLD_LAZY);
+  void *handle = trace_dlopen("libicns.so.1", RTLD_LAZY);
   char *error = dlerror();
 
   if (!handle) {
@@ -37,17 +37,19 @@ echo "ICON:newIcon" > $pipe
 #include <strings.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "fltk-dialog.hpp"
+#include "line_reader.hpp"
 #include "icon_png.h"
-#include "icon_ind_png.h"
+#include "icon_ind_rgba.h"
 #include "indicator_gtk.h"
 
 /* From the Tango icon theme, released into the Public Domain.
  * https://commons.wikimedia.org/wiki/File:Image-missing.svg
  */
-#include "image_missing_png.h"
+#include "image_missing_rgba.h"
 
 #define DEFAULT_SIZE  48
 #define ICON_SCALE    0.86  //0.72
@@ -181,20 +183,20 @@ static void check_icons(const char *icon)
   }
 
   if (!rgb) {
-    rgb = new Fl_PNG_Image(NULL, image_missing_png, image_missing_png_len);
+    rgb = rgba_image(image_missing_rgba);
   }
 }
 
-static FILE *open_named_pipe(void)
+static int open_named_pipe(void)
 {
-  FILE *fp = NULL;
+  int fd;
 
   if (access(named_pipe, F_OK) == -1) {
     /* path doesn't exist -> make FIFO */
     if (mkfifo(named_pipe, 0644) == -1) {
       /* cannot make FIFO */
       perror("mkfifo()");
-      return NULL;
+      return -1;
     }
   } else {
     /* path exists -> check if it's a FIFO */
@@ -203,64 +205,69 @@ static FILE *open_named_pipe(void)
 
     if ((st.st_mode & S_IFMT) != S_IFIFO) {
       std::cerr << "error: file is not a FIFO: " << named_pipe << std::endl;
-      return NULL;
+      return -1;
     }
   }
 
-  if ((fp = fopen(named_pipe, "r+")) == NULL) {
-    perror("fopen()");
+  /* O_RDWR keeps the FIFO open when the last writer disconnects */
+  if ((fd = open(named_pipe, O_RDWR|O_CLOEXEC)) == -1) {
+    perror("open()");
   }
 
-  return fp;
+  return fd;
 }
 
 extern "C" void *getline_xlib(void *)
 {
-  FILE *fp;
-  char *line = NULL;
-  size_t n = 0;
-  ssize_t len;
+  std::vector<line_view> lines;
+  int fd;
 
-  if ((fp = open_named_pipe()) == NULL) {
+  if ((fd = open_named_pipe()) == -1) {
     return nullptr;
   }
 
-  while ((len = getline(&line, &n, fp)) != -1) {
-    if (strcasecmp(line, "QUIT\n") == 0) {
-      win->hide();
+  line_reader reader(fd, 4096);
 
-      if (rgb) {
-        delete rgb;
-      }
+  while (reader.next_batch(lines)) {
+    for (size_t i = 0; i < lines.size(); ++i) {
+      char *line = lines[i].data;
+
+      if (strcasecmp(line, "QUIT") == 0) {
+        win->hide();
 
-      Fl::awake();
+        if (rgb) {
+          delete rgb;
+        }
 
-      return nullptr;
-    } else if (len > 5 && strncasecmp(line, "ICON:", 5) == 0) {
-      Fl::lock();
+        Fl::awake();
+        close(fd);
 
-      line[len - 1] = '\0';  /* remove trailing newline */
-      check_icons(line + 5);
+        return nullptr;
+      } else if (lines[i].len > 5 && strncasecmp(line, "ICON:", 5) == 0) {
+        Fl::lock();
 
-      if (rgb) {
-        /* make icon a bit smaller than the area */
-        int n = box->w() * ICON_SCALE;
-        box->image(rgb->copy(n, n));
-        delete rgb;
-      }
+        check_icons(line + 5);
 
-      win->redraw();
+        if (rgb) {
+          /* make icon a bit smaller than the area */
+          int n = box->w() * ICON_SCALE;
+          box->image(rgb->copy(n, n));
+          delete rgb;
+        }
+
+        win->redraw();
 
-      Fl::unlock();
-      Fl::awake();
+        Fl::unlock();
+        Fl::awake();
 
-      rgb = NULL;
-    } else if (strcasecmp(line, "RUN\n") == 0) {
-      box->do_callback();
+        rgb = NULL;
+      } else if (strcasecmp(line, "RUN") == 0) {
+        box->do_callback();
+      }
     }
   }
 
-  fclose(fp);
+  close(fd);
 
   return nullptr;
 }
@@ -288,7 +295,7 @@ static int create_corner_window(const char *icon)
       //std::cout << "n == " << n << std::endl;
       box->image(rgb->copy(n, n));
     } else {
-      rgb = new Fl_PNG_Image(NULL, icon_ind_png, icon_ind_png_len);
+      rgb = rgba_image(icon_ind_rgba);
       box->image(rgb->copy());
     }
 
@@ -322,6 +329,7 @@ static int dlopen_start_indicator_qt(const char *icon)
 {
   std::string plugin, tmp;
   void *handle = NULL, *p;
+  int fd = -1;
 
   PROTO(int, start_indicator_qt, (int, const char*, const char*, const char*, bool))
   p = dlopen_qtplugin(plugin, handle, "start_indicator_qt");
@@ -330,19 +338,17 @@ static int dlopen_start_indicator_qt(const char *icon)
     return -1;
   }
 
-  if ((!icon || strlen(icon) == 0) && save_to_temp(icon_png, icon_png_len, ".png", tmp)) {
+  /* Qt reads the icon in our own process, so it can be loaded from memory */
+  if ((!icon || strlen(icon) == 0) && (fd = save_to_memfd(icon_png, icon_png_len, "icon.png", tmp)) != -1) {
     icon = tmp.c_str();
   }
 
   start_indicator_qt = reinterpret_cast<start_indicator_qt_t>(p);
   int rv = start_indicator_qt(0, command, icon, named_pipe, auto_close);
   dlclose(handle);
-#ifndef USE_EXTERNAL_PLUGINS
-  unlink(plugin.c_str());
-#endif
 
-  if (!tmp.empty()) {
-    unlink(tmp.c_str());
+  if (fd != -1) {
+    close(fd);
   }
 
   return rv;
@@ -36,9 +36,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "fltk-dialog.hpp"
+#include "trace.hpp"
+#include "line_reader.hpp"
 #include "icon_png.h"
 #include "indicator_gtk.h"
 
@@ -144,16 +147,16 @@ static void set_icon(const char *icon, AppIndicator *indicator)
   }
 }
 
-static FILE *open_named_pipe(void)
+static int open_named_pipe(void)
 {
-  FILE *fp = NULL;
+  int fd;
 
   if (access(named_pipe, F_OK) == -1) {
     /* path doesn't exist -> make FIFO */
     if (mkfifo(named_pipe, 0644) == -1) {
       /* cannot make FIFO */
       perror("mkfifo()");
-      return NULL;
+      return -1;
     }
   } else {
     /* path exists -> check if it's a FIFO */
@@ -162,43 +165,48 @@ static FILE *open_named_pipe(void)
 
     if ((st.st_mode & S_IFMT) != S_IFIFO) {
       std::cerr << "error: file is not a FIFO: " << named_pipe << std::endl;
-      return NULL;
+      return -1;
     }
   }
 
-  if ((fp = fopen(named_pipe, "r+")) == NULL) {
-    perror("fopen()");
+  /* O_RDWR keeps the FIFO open when the last writer disconnects */
+  if ((fd = open(named_pipe, O_RDWR|O_CLOEXEC)) == -1) {
+    perror("open()");
   }
 
-  return fp;
+  return fd;
 }
 
 extern "C" void *getline_gtk(void *v)
 {
-  FILE *fp;
-  char *line = NULL;
-  size_t n = 0;
-  ssize_t len;
+  std::vector<line_view> lines;
+  int fd;
 
-  if ((fp = open_named_pipe()) == NULL) {
+  if ((fd = open_named_pipe()) == -1) {
     return nullptr;
   }
 
-  while ((len = getline(&line, &n, fp)) != -1) {
-    if (strcasecmp(line, "QUIT\n") == 0) {
-      gtk_main_quit();
-      dlclose(libappindicator_handle);
-      dlclose(libgtk_handle);
-      return nullptr;
-    } else if (len > 5 && strncasecmp(line, "ICON:", 5) == 0) {
-      line[len - 1] = '\0';  /* remove trailing newline */
-      set_icon(line + 5, reinterpret_cast<AppIndicator *>(v));
-    } else if (strcasecmp(line, "RUN\n") == 0) {
-      callback();
+  line_reader reader(fd, 4096);
+
+  while (reader.next_batch(lines)) {
+    for (size_t i = 0; i < lines.size(); ++i) {
+      char *line = lines[i].data;
+
+      if (strcasecmp(line, "QUIT") == 0) {
+        gtk_main_quit();
+        dlclose(libappindicator_handle);
+        dlclose(libgtk_handle);
+        close(fd);
+        return nullptr;
+      } else if (lines[i].len > 5 && strncasecmp(line, "ICON:", 5) == 0) {
+        set_icon(line + 5, reinterpret_cast<AppIndicator *>(v));
+      } else if (strcasecmp(line, "RUN") == 0) {
+        callback();
+      }
     }
   }
 
-  fclose(fp);
+  close(fd);
 
   return nullptr;
 }
@@ -245,7 +253,7 @@ int start_indicator_gtk(const char *command_, const char *icon, const char *name
 
   /* dlopen() libraries */
 
-  libgtk_handle = dlopen("libgtk-x11-2.0.so.0", RTLD_LAZY|RTLD_GLOBAL);
+  libgtk_handle = trace_dlopen("libgtk-x11-2.0.so.0", RTLD_LAZY|RTLD_GLOBAL);
   err = dlerror();
   if (!libgtk_handle) {
     handle_dlopen_error(err);
@@ -253,7 +261,7 @@ int start_indicator_gtk(const char *command_, const char *icon, const char *name
   }
 
   /* RTLD_NODELETE is needed to prevent memory access violation on dlclose() */
-  libappindicator_handle = dlopen("libappindicator3.so.1", RTLD_LAZY|RTLD_NODELETE);
+  libappindicator_handle = trace_dlopen("libappindicator3.so.1", RTLD_LAZY|RTLD_NODELETE);
   err = dlerror();
 
   if (!libappindicator_handle) {
@@ -261,7 +269,7 @@ int start_indicator_gtk(const char *command_, const char *icon, const char *name
       std::cerr << err << std::endl;
     }
 
-    libappindicator_handle = dlopen("libappindicator.so.1", RTLD_LAZY|RTLD_NODELETE);
+    libappindicator_handle = trace_dlopen("libappindicator.so.1", RTLD_LAZY|RTLD_NODELETE);
     err = dlerror();
 
     if (!libappindicator_handle) {
@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "line_reader.hpp"
+
+#define BUFFER_ALIGN  64
+
+
+static char *alloc_buffer(size_t size)
+{
+  void *p = NULL;
+
+  /* one extra byte to terminate an unterminated last line */
+  if (posix_memalign(&p, BUFFER_ALIGN, size + 1) != 0) {
+    perror("posix_memalign()");
+    abort();
+  }
+  return reinterpret_cast<char *>(p);
+}
+
+line_reader::line_reader(int fd, size_t size)
+ : fd_(fd),
+   size_(size),
+   start_(0),
+   scan_(0),
+   end_(0),
+   eof_(false),
+   error_(false)
+{
+  buf_ = alloc_buffer(size_);
+}
+
+line_reader::~line_reader()
+{
+  free(buf_);
+}
+
+void line_reader::split(std::vector<line_view> &lines)
+{
+  newline_scanner scanner(buf_ + scan_, buf_ + end_);
+  char *start = buf_ + start_;
+  const char *nl;
+
+  while ((nl = scanner.next()) != NULL) {
+    line_view l;
+    l.data = start;
+    l.len = nl - start;
+    start[l.len] = '\0';
+    lines.push_back(l);
+    start += l.len + 1;
+  }
+
+  start_ = start - buf_;
+  scan_ = end_;
+}
+
+/* read more input; returns false if nothing was read */
+bool line_reader::fill()
+{
+  /* move the incomplete line to the front */
+  if (start_ > 0) {
+    memmove(buf_, buf_ + start_, end_ - start_);
+    end_ -= start_;
+    scan_ -= start_;
+    start_ = 0;
+  }
+
+  /* the line doesn't fit into the buffer */
+  if (end_ == size_) {
+    char *p = alloc_buffer(size_ * 2);
+    memcpy(p, buf_, end_);
+    free(buf_);
+    buf_ = p;
+    size_ *= 2;
+  }
+
+  for (;;) {
+    ssize_t n = read(fd_, buf_ + end_, size_ - end_);
+
+    if (n > 0) {
+      end_ += n;
+      return true;
+    } else if (n == 0) {
+      eof_ = true;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      perror("read()");
+      eof_ = true;
+      error_ = true;
+    }
+    return false;
+  }
+}
+
+bool line_reader::next_batch(std::vector<line_view> &lines)
+{
+  lines.clear();
+
+  for (;;) {
+    split(lines);
+
+    if (!lines.empty()) {
+      return true;
+    }
+
+    if (eof_ || !fill()) {
+      break;
+    }
+  }
+
+  if (eof_ && start_ < end_) {
+    line_view l;
+    l.data = buf_ + start_;
+    l.len = end_ - start_;
+    l.data[l.len] = '\0';
+    lines.push_back(l);
+    start_ = scan_ = end_;
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,136 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LINE_READER_HPP
+#define LINE_READER_HPP
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+
+/* Finds all newline characters in [p, end).  64 bytes are compared at a
+ * time and the positions are taken from the resulting bit mask, so unlike
+ * calling memchr() once per line the cost doesn't depend on the number of
+ * lines.  Shorter tails are scanned with memchr(). */
+class newline_scanner
+{
+public:
+  newline_scanner(const char *p, const char *end)
+   : pos_(p),
+     end_(end),
+     base_(p),
+     mask_(0)
+  { }
+
+  /* returns NULL when there are no more newlines */
+  const char *next();
+
+private:
+  const char *pos_, *end_, *base_;
+  uint64_t mask_;
+};
+
+inline const char *newline_scanner::next()
+{
+  while (mask_ == 0) {
+#ifdef __SSE2__
+    if (end_ - pos_ >= 64) {
+      const __m128i nl = _mm_set1_epi8('\n');
+      const __m128i *v = reinterpret_cast<const __m128i *>(pos_);
+      uint64_t m0 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v), nl));
+      uint64_t m1 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 1), nl));
+      uint64_t m2 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 2), nl));
+      uint64_t m3 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(v + 3), nl));
+
+      mask_ = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+      base_ = pos_;
+      pos_ += 64;
+      continue;
+    }
+#endif
+    if (pos_ >= end_) {
+      return NULL;
+    }
+
+    const char *q = reinterpret_cast<const char *>(memchr(pos_, '\n', end_ - pos_));
+    pos_ = q ? q + 1 : end_;
+    return q;
+  }
+
+  const char *q = base_ + __builtin_ctzll(mask_);
+  mask_ &= mask_ - 1;
+  return q;
+}
+
+
+/* A line without its newline character.  The line is terminated with a
+ * NUL byte in place of the newline, so data can be used as a C string. */
+struct line_view
+{
+  char *data;
+  size_t len;
+};
+
+
+/* Reads lines from a file descriptor into a large aligned buffer and hands
+ * them out in batches of views pointing into that buffer.  Works with
+ * blocking and non-blocking descriptors. */
+class line_reader
+{
+public:
+  explicit line_reader(int fd, size_t size = 1024*1024);
+  ~line_reader();
+
+  /* Returns all complete lines that are buffered, reading more input if
+   * there are none.  The views are valid until the next call.  An
+   * unterminated last line is returned at the end of the input.
+   * Returns false if no line is available, either because the input has
+   * ended (see eof()) or because a non-blocking read would block. */
+  bool next_batch(std::vector<line_view> &lines);
+
+  /* a read error also ends the input */
+  bool eof() const { return eof_; }
+  bool error() const { return error_; }
+  int fd() const { return fd_; }
+
+private:
+  int fd_;
+  char *buf_;
+  size_t size_;
+  size_t start_;  /* beginning of the first incomplete line */
+  size_t scan_;   /* everything before this was already searched */
+  size_t end_;
+  bool eof_;
+  bool error_;
+
+  void split(std::vector<line_view> &lines);
+  bool fill();
+};
+
+#endif  /* !LINE_READER_HPP */
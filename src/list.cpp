@@ -0,0 +1,221 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "fltk-dialog.hpp"
+#include "frame_update.hpp"
+#include "line_reader.hpp"
+#include "list_table.hpp"
+
+static Fl_Double_Window *win;
+static list_table *table;
+static table_data *data;
+static bool csv = false;
+static int ret = 1;
+
+static void close_cb(Fl_Widget *, long p) {
+  win->hide();
+  ret = p;
+}
+
+static void activate_cb() {
+  close_cb(NULL, 0);
+}
+
+static void frame_cb()
+{
+  table->sync();
+}
+
+static frame_update frame(frame_cb);
+
+/* new rows are shown at most once per frame */
+static void schedule_update()
+{
+  frame.request();
+}
+
+/* the input couldn't be read completely */
+static void read_failed_cb(void *)
+{
+  if (win->shown()) {
+    close_cb(NULL, 1);
+  }
+}
+
+/* parses rows from stdin; the rows can be selected while more are read */
+static void *list_read(void *)
+{
+  line_reader reader(STDIN_FILENO);
+  row_parser parser(csv);
+  std::vector<line_view> lines;
+
+  while (reader.next_batch(lines)) {
+    data->lock();
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+      if (parser.feed(lines[i].data, lines[i].len)) {
+        data->add_row(parser.fields().data(), parser.fields().size());
+      }
+    }
+
+    data->unlock();
+    schedule_update();
+  }
+
+  if (!parser.finish()) {
+    std::cerr << "error: bad CSV input: quoted field not closed at the end of the input" << std::endl;
+    Fl::awake(read_failed_cb);
+  } else if (reader.error()) {
+    Fl::awake(read_failed_cb);
+  }
+
+  return NULL;
+}
+
+int dialog_list(const std::vector<std::string> &columns, const std::vector<std::string> &cells, bool multiple,
+                int print_column, bool csv_, char separator)
+{
+  Fl_Group         *g, *g_inside, *buttongroup;
+  Fl_Box           *dummy1, *dummy2;
+  Fl_Return_Button *but_ok;
+  Fl_Button        *but_cancel;
+  pthread_t th;
+  int range;
+
+  csv = csv_;
+  data = new table_data(columns.size());
+
+  /* rows given as arguments */
+  for (size_t i = 0; i < cells.size(); i += columns.size()) {
+    std::vector<str_view> fields;
+
+    for (size_t j = i; j < cells.size() && j < i + columns.size(); ++j) {
+      str_view v = { cells[j].data(), cells[j].size() };
+      fields.push_back(v);
+    }
+    data->add_row(fields.data(), fields.size());
+  }
+
+  if (!title) {
+    title = "Select items from the list";
+  }
+
+  win = new Fl_Double_Window(420, 356, title);
+  win->callback(close_cb, 1);
+  {
+    g = new Fl_Group(0, 0, 420, 310);
+    {
+      g_inside = new Fl_Group(0, 0, 420, 310);
+      {
+        table = new list_table(10, 10, 400, 299, data, columns);
+        table->type(multiple ? Fl_Table_Row::SELECT_MULTI : Fl_Table_Row::SELECT_SINGLE);
+        table->activate_callback(activate_cb);
+        table->sync();
+        dummy1 = new Fl_Box(10, 308, 400, 1);
+        dummy1->box(FL_NO_BOX);
+      }
+      g_inside->resizable(table);
+      g_inside->end();
+    }
+    g->resizable(g_inside);
+    g->end();
+
+    buttongroup = new Fl_Group(0, 310, 420, 42);
+    {
+      int but_w = measure_button_width(fl_cancel, 20);
+      range = but_w + 40;
+      but_cancel = new Fl_Button(win->w() - 10 - but_w, 320, but_w, 26, fl_cancel);
+      but_cancel->callback(close_cb, 1);
+      but_w = measure_button_width(fl_ok, 40);
+      but_ok = new Fl_Return_Button(but_cancel->x() - 10 - but_w, 320, but_w, 26, fl_ok);
+      but_ok->callback(close_cb, 0);
+      dummy2 = new Fl_Box(but_ok->x() - 1, 310, 1, 1);
+      dummy2->box(FL_NO_BOX);
+    }
+    buttongroup->resizable(dummy2);
+    buttongroup->end();
+  }
+
+  /* columns are sorted on another thread */
+  Fl::lock();
+
+  /* without any rows as arguments they are read from stdin */
+  if (cells.empty()) {
+    int errsv = pthread_create(&th, 0, &list_read, NULL);
+
+    if (errsv != 0) {
+      errno = errsv;
+      perror("pthread_create()");
+      return 1;
+    }
+    pthread_detach(th);
+  }
+
+  run_window(win, g, range, 100);
+
+  if (ret == 0) {
+    std::string list;
+    bool first = true;
+
+    data->lock();
+
+    for (int r = 0; r < table->rows(); ++r) {
+      if (!table->row_selected(r)) {
+        continue;
+      }
+
+      size_t row = table->data_row(r);
+
+      for (size_t c = 0; c < data->columns(); ++c) {
+        /* print_column is 1-based, 0 means all columns */
+        if (print_column > 0 && c != static_cast<size_t>(print_column - 1)) {
+          continue;
+        }
+
+        if (!first) {
+          list.push_back(separator);
+        }
+        first = false;
+
+        const str_view &v = data->cell(row, c);
+        list.append(quote);
+        list.append(v.data, v.len);
+        list.append(quote);
+      }
+    }
+
+    data->unlock();
+    std::cout << list << std::endl;
+  }
+
+  return ret;
+}
@@ -0,0 +1,539 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "list_table.hpp"
+
+/* fewer rows than this are sorted on one thread */
+#define MIN_ROWS_PER_THREAD  65536
+#define MAX_THREADS          16
+
+
+table_data::table_data(size_t columns)
+ : cols_(columns),
+   rows_(0)
+{
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+table_data::~table_data()
+{
+  pthread_mutex_destroy(&mutex_);
+}
+
+void table_data::add_row(const str_view *fields, size_t count)
+{
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    str_view v = { "", 0 };
+
+    if (i < count && fields[i].len > 0) {
+      v.data = arena_.store(fields[i].data, fields[i].len);
+      v.len = fields[i].len;
+    }
+    cols_[i].push_back(v);
+  }
+  ++rows_;
+}
+
+
+row_parser::row_parser(bool csv)
+ : csv_(csv),
+   quoted_(false)
+{
+}
+
+bool row_parser::feed(const char *line, size_t len)
+{
+  /* CRLF line endings */
+  if (len > 0 && line[len - 1] == '\r') {
+    --len;
+  }
+
+  if (!csv_) {
+    const char *end = line + len;
+    const char *q;
+
+    fields_.clear();
+
+    while ((q = reinterpret_cast<const char *>(memchr(line, '\t', end - line))) != NULL) {
+      str_view v = { line, static_cast<size_t>(q - line) };
+      fields_.push_back(v);
+      line = q + 1;
+    }
+
+    str_view v = { line, static_cast<size_t>(end - line) };
+    fields_.push_back(v);
+    return true;
+  }
+
+  if (quoted_) {
+    /* the newline was part of a quoted field */
+    buf_.push_back('\n');
+  } else {
+    buf_.clear();
+    ends_.clear();
+  }
+
+  for (size_t i = 0; i < len; ++i) {
+    char c = line[i];
+
+    if (quoted_) {
+      if (c != '"') {
+        buf_.push_back(c);
+      } else if (i + 1 < len && line[i + 1] == '"') {
+        buf_.push_back('"');
+        ++i;
+      } else {
+        quoted_ = false;
+      }
+    } else if (c == ',') {
+      ends_.push_back(buf_.size());
+    } else if (c == '"') {
+      quoted_ = true;
+    } else {
+      buf_.push_back(c);
+    }
+  }
+
+  if (quoted_) {
+    return false;
+  }
+
+  ends_.push_back(buf_.size());
+  fields_.clear();
+
+  for (size_t i = 0, start = 0; i < ends_.size(); ++i) {
+    str_view v = { buf_.data() + start, ends_[i] - start };
+    fields_.push_back(v);
+    start = ends_[i];
+  }
+
+  return true;
+}
+
+bool row_parser::finish()
+{
+  bool rv = !quoted_;
+
+  quoted_ = false;
+  buf_.clear();
+  ends_.clear();
+  return rv;
+}
+
+
+namespace
+{
+  /* Sort keys are cached per row: numbers if every non-empty cell of the
+   * column is one, otherwise the first 8 bytes of the text in big endian
+   * order, so most comparisons don't have to touch the text. */
+  struct sort_key
+  {
+    double number;
+    uint64_t prefix;
+  };
+
+  struct row_less
+  {
+    const std::vector<sort_key> *keys;
+    const str_view *cells;
+    bool numeric;
+
+    bool operator()(uint32_t a, uint32_t b) const {
+      const sort_key &ka = (*keys)[a];
+      const sort_key &kb = (*keys)[b];
+
+      if (numeric) {
+        if (ka.number != kb.number) {
+          return ka.number < kb.number;
+        }
+      } else if (ka.prefix != kb.prefix) {
+        return ka.prefix < kb.prefix;
+      } else {
+        const str_view &va = cells[a];
+        const str_view &vb = cells[b];
+
+        if (va.len > 8 && vb.len > 8) {
+          int rv = memcmp(va.data + 8, vb.data + 8, std::min(va.len, vb.len) - 8);
+
+          if (rv != 0) {
+            return rv < 0;
+          }
+        }
+
+        if (va.len != vb.len) {
+          return va.len < vb.len;
+        }
+      }
+
+      /* keep equal rows in input order */
+      return a < b;
+    }
+  };
+
+  struct sort_job
+  {
+    uint32_t *begin, *end;
+    const row_less *less;
+    pthread_t thread;
+    bool started;
+  };
+}
+
+static void *sort_range(void *v)
+{
+  sort_job *j = reinterpret_cast<sort_job *>(v);
+  std::sort(j->begin, j->end, *j->less);
+  return NULL;
+}
+
+static inline uint64_t text_prefix(const str_view &v)
+{
+  uint64_t key = 0;
+
+  for (size_t i = 0; i < 8; ++i) {
+    key <<= 8;
+    if (i < v.len) {
+      key |= static_cast<unsigned char>(v.data[i]);
+    }
+  }
+  return key;
+}
+
+/* sorts the first `rows' cells of a column */
+static void build_order(const str_view *cells, size_t rows, std::vector<uint32_t> &out)
+{
+  std::vector<sort_key> keys(rows);
+  row_less less = { &keys, cells, true };
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t n = (rows + MIN_ROWS_PER_THREAD - 1) / MIN_ROWS_PER_THREAD;
+  std::vector<sort_job> jobs;
+
+  for (size_t i = 0; i < rows; ++i) {
+    const str_view &v = cells[i];
+    char *end;
+
+    keys[i].prefix = text_prefix(v);
+
+    if (less.numeric) {
+      /* empty cells sort first */
+      keys[i].number = (v.len == 0) ? -HUGE_VAL : strtod(v.data, &end);
+
+      if (v.len > 0 && (end != v.data + v.len || end == v.data || isnan(keys[i].number))) {
+        less.numeric = false;
+      }
+    }
+  }
+
+  out.resize(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    out[i] = i;
+  }
+
+  if (ncpu < 1) {
+    ncpu = 1;
+  } else if (ncpu > MAX_THREADS) {
+    ncpu = MAX_THREADS;
+  }
+
+  if (n > static_cast<size_t>(ncpu)) {
+    n = ncpu;
+  } else if (n == 0) {
+    n = 1;
+  }
+
+  /* sort one range per thread ... */
+  jobs.resize(n);
+
+  for (size_t i = 0; i < n; ++i) {
+    jobs[i].begin = out.data() + rows * i / n;
+    jobs[i].end = out.data() + rows * (i + 1) / n;
+    jobs[i].less = &less;
+    jobs[i].started = (i > 0 && pthread_create(&jobs[i].thread, NULL, sort_range, &jobs[i]) == 0);
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    if (jobs[i].started) {
+      pthread_join(jobs[i].thread, NULL);
+    } else {
+      sort_range(&jobs[i]);
+    }
+  }
+
+  /* ... and merge neighbouring ranges until one is left */
+  for (size_t step = 1; step < n; step *= 2) {
+    for (size_t i = 0; i + step < n; i += 2*step) {
+      size_t last = std::min(i + 2*step, n) - 1;
+      std::inplace_merge(jobs[i].begin, jobs[i + step].begin, jobs[last].end, less);
+    }
+  }
+}
+
+
+list_table::list_table(int X, int Y, int W, int H, table_data *data, const std::vector<std::string> &headers)
+ : Fl_Table_Row(X, Y, W, H),
+   data_(data),
+   headers_(headers),
+   cache_(data->columns()),
+   sort_col_(-1),
+   descending_(false),
+   sorted_rows_(0),
+   sorting_(false),
+   activate_cb_(NULL)
+{
+  int ncols = data->columns();
+
+  cols(ncols);
+  col_header(1);
+  col_resize(1);
+  row_height_all(fl_height(FL_HELVETICA, FL_NORMAL_SIZE) + 4);
+  col_width_all((W - Fl::scrollbar_size() - Fl::box_dw(box())) / ncols);
+  when(FL_WHEN_RELEASE);
+  callback(event_cb, this);
+  end();
+}
+
+void list_table::sync()
+{
+  data_->lock();
+  size_t n = data_->rows();
+  data_->unlock();
+
+  size_t old = rows();
+
+  if (n == old) {
+    return;
+  }
+
+  /* Rows added to a sorted table go to the end, so the rows that are
+   * already shown (and their selection) don't move.  The cached orders
+   * don't cover the new rows. */
+  if (!order_.empty()) {
+    for (size_t i = old; i < n; ++i) {
+      order_.push_back(i);
+    }
+  }
+
+  for (size_t i = 0; i < cache_.size(); ++i) {
+    cache_[i].clear();
+  }
+  rows(n);
+}
+
+struct list_table::sort_request
+{
+  list_table *table;
+  int col;
+  bool descending;
+  std::vector<str_view> cells;
+  std::vector<uint32_t> order;
+};
+
+void list_table::sort(int col)
+{
+  size_t n = rows();
+  bool descending = false;
+
+  if (col < 0 || col >= cols() || n < 2 || sorting_) {
+    return;
+  }
+
+  /* a click on a partially sorted column sorts the new rows too */
+  if (col == sort_col_) {
+    descending = (sorted_rows_ == n) ? !descending_ : descending_;
+  }
+
+  if (!cache_[col].empty()) {
+    install(col, descending, cache_[col]);
+    return;
+  }
+
+  /* the reader thread may add rows meanwhile, so the worker gets its own
+   * copy of the views; the text they point to doesn't move */
+  sort_request *req = new sort_request;
+  req->table = this;
+  req->col = col;
+  req->descending = descending;
+
+  data_->lock();
+  req->cells.assign(data_->column(col), data_->column(col) + n);
+  data_->unlock();
+
+  pthread_t th;
+  int errsv = pthread_create(&th, NULL, sort_thread, req);
+
+  if (errsv != 0) {
+    errno = errsv;
+    perror("pthread_create()");
+    delete req;
+    return;
+  }
+  pthread_detach(th);
+
+  sorting_ = true;
+  fl_cursor(FL_CURSOR_WAIT);
+}
+
+void *list_table::sort_thread(void *v)
+{
+  sort_request *req = reinterpret_cast<sort_request *>(v);
+  build_order(req->cells.data(), req->cells.size(), req->order);
+  Fl::awake(sort_done_cb, req);
+  return NULL;
+}
+
+void list_table::sort_done_cb(void *v)
+{
+  sort_request *req = reinterpret_cast<sort_request *>(v);
+  list_table *t = req->table;
+
+  /* rows that arrived during the sort aren't covered by it */
+  if (req->order.size() == static_cast<size_t>(t->rows())) {
+    t->cache_[req->col] = req->order;
+  }
+
+  t->sorting_ = false;
+  fl_cursor(FL_CURSOR_DEFAULT);
+  t->install(req->col, req->descending, req->order);
+  delete req;
+}
+
+/* shows the rows in a new order, which may cover only the first rows */
+void list_table::install(int col, bool descending, const std::vector<uint32_t> &order)
+{
+  std::vector<char> selected;
+  size_t n = rows();
+
+  /* remember the selection by data row */
+  selected.resize(n);
+  for (size_t r = 0; r < n; ++r) {
+    selected[data_row(r)] = row_selected(r);
+  }
+
+  order_ = order;
+
+  if (descending) {
+    std::reverse(order_.begin(), order_.end());
+  }
+
+  for (size_t i = order.size(); i < n; ++i) {
+    order_.push_back(i);
+  }
+
+  sort_col_ = col;
+  descending_ = descending;
+  sorted_rows_ = order.size();
+
+  for (size_t r = 0; r < n; ++r) {
+    select_row(r, selected[data_row(r)]);
+  }
+  redraw();
+}
+
+void list_table::event_cb(Fl_Widget *o, void *v)
+{
+  list_table *t = reinterpret_cast<list_table *>(v);
+
+  if (Fl::event() != FL_RELEASE || Fl::event_button() != FL_LEFT_MOUSE) {
+    return;
+  }
+
+  switch (t->callback_context()) {
+    case CONTEXT_COL_HEADER:
+      t->sort(t->callback_col());
+      break;
+    case CONTEXT_CELL:
+      if (Fl::event_clicks() > 0 && t->activate_cb_) {
+        t->activate_cb_();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void list_table::draw_cell(TableContext context, int R, int C, int X, int Y, int W, int H)
+{
+  switch (context) {
+    case CONTEXT_STARTPAGE:
+      fl_font(FL_HELVETICA, FL_NORMAL_SIZE);
+      data_->lock();
+      return;
+
+    case CONTEXT_ENDPAGE:
+      data_->unlock();
+      return;
+
+    case CONTEXT_COL_HEADER:
+      fl_push_clip(X, Y, W, H);
+      {
+        fl_draw_box(FL_THIN_UP_BOX, X, Y, W, H, col_header_color());
+        fl_color(FL_FOREGROUND_COLOR);
+        fl_draw(headers_[C].c_str(), X + 4, Y, W - 8, H, FL_ALIGN_LEFT);
+
+        if (C == sort_col_) {
+          int ax = X + W - 10;
+          int ay = Y + H/2;
+
+          if (sorted_rows_ < static_cast<size_t>(rows())) {
+            if (descending_) {
+              fl_loop(ax - 4, ay - 2, ax + 4, ay - 2, ax, ay + 3);
+            } else {
+              fl_loop(ax - 4, ay + 3, ax + 4, ay + 3, ax, ay - 2);
+            }
+          } else if (descending_) {
+            fl_polygon(ax - 4, ay - 2, ax + 4, ay - 2, ax, ay + 3);
+          } else {
+            fl_polygon(ax - 4, ay + 3, ax + 4, ay + 3, ax, ay - 2);
+          }
+        }
+      }
+      fl_pop_clip();
+      return;
+
+    case CONTEXT_CELL:
+      fl_push_clip(X, Y, W, H);
+      {
+        const str_view &v = data_->cell(data_row(R), C);
+        Fl_Color bg = row_selected(R) ? selection_color() : FL_BACKGROUND2_COLOR;
+
+        fl_color(bg);
+        fl_rectf(X, Y, W, H);
+        fl_color(fl_contrast(FL_FOREGROUND_COLOR, bg));
+        fl_draw(v.data, static_cast<int>(v.len), X + 4, Y + H - fl_descent() - 2);
+      }
+      fl_pop_clip();
+      return;
+
+    default:
+      return;
+  }
+}
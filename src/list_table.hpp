@@ -0,0 +1,143 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIST_TABLE_HPP
+#define LIST_TABLE_HPP
+
+#include <FL/Fl_Table_Row.H>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fltk-dialog.hpp"
+
+
+/* The rows of the --list dialog.  Cells are stored by column as views into
+ * a text_arena, so each cell is followed by a NUL byte.  Rows can be
+ * appended by one thread while another one reads the rows that are already
+ * there; use lock() around both. */
+class table_data
+{
+public:
+  explicit table_data(size_t columns);
+  ~table_data();
+
+  void lock() { pthread_mutex_lock(&mutex_); }
+  void unlock() { pthread_mutex_unlock(&mutex_); }
+
+  size_t columns() const { return cols_.size(); }
+  size_t rows() const { return rows_; }
+  const str_view &cell(size_t row, size_t col) const { return cols_[col][row]; }
+  const str_view *column(size_t col) const { return cols_[col].data(); }
+
+  /* copies the fields; missing fields are left empty and extra fields
+   * are ignored */
+  void add_row(const str_view *fields, size_t count);
+
+private:
+  text_arena arena_;
+  std::vector<std::vector<str_view> > cols_;
+  size_t rows_;
+  pthread_mutex_t mutex_;
+};
+
+
+/* Splits lines of tab or comma separated values into fields.  CSV fields
+ * may be quoted, and quoted fields may contain separators, doubled quotes
+ * and newlines, so a row can span several lines. */
+class row_parser
+{
+public:
+  explicit row_parser(bool csv);
+
+  /* returns true when a row is complete; its fields are then valid until
+   * the next call */
+  bool feed(const char *line, size_t len);
+
+  /* call at the end of the input; returns false if a quoted field was
+   * never closed, in which case the last row is dropped */
+  bool finish();
+
+  const std::vector<str_view> &fields() const { return fields_; }
+
+private:
+  bool csv_, quoted_;
+  std::string buf_;
+  std::vector<size_t> ends_;
+  std::vector<str_view> fields_;
+};
+
+
+/* A virtual table showing a table_data, with sorting by a click on a
+ * column header.  The sort order of a column is cached, so sorting by it
+ * again or reversing it doesn't compare any cells.  Rows that arrive after
+ * sorting are appended unsorted; the arrow of the sort column is then
+ * drawn hollow and the next click on it sorts all rows again.
+ *
+ * Columns that weren't sorted before are sorted on a worker thread on a
+ * copy of the cells; the current order is shown until the new one is
+ * installed.  Fl::lock() must have been called. */
+class list_table : public Fl_Table_Row
+{
+public:
+  list_table(int X, int Y, int W, int H, table_data *data, const std::vector<std::string> &headers);
+
+  /* shows the rows that were added to the data; call it at most once
+   * per frame while rows are added */
+  void sync();
+
+  /* the row of the data shown in table row r */
+  size_t data_row(int r) const { return order_.empty() ? r : order_[r]; }
+
+  void sort(int col);
+
+  /* cb() is called when a row is double-clicked */
+  void activate_callback(void (*cb)()) { activate_cb_ = cb; }
+
+protected:
+  void draw_cell(TableContext context, int R, int C, int X, int Y, int W, int H);
+
+private:
+  table_data *data_;
+  const std::vector<std::string> &headers_;
+  std::vector<uint32_t> order_;  /* empty if unsorted */
+  std::vector<std::vector<uint32_t> > cache_;  /* ascending order per column */
+  int sort_col_;
+  bool descending_;
+  size_t sorted_rows_;  /* rows covered by the sort */
+  bool sorting_;  /* a worker thread is running */
+  void (*activate_cb_)();
+
+  struct sort_request;
+
+  void install(int col, bool descending, const std::vector<uint32_t> &order);
+
+  static void *sort_thread(void *v);
+  static void sort_done_cb(void *v);
+  static void event_cb(Fl_Widget *o, void *v);
+};
+
+#endif  /* !LIST_TABLE_HPP */
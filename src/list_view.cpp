@@ -0,0 +1,337 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "fltk-dialog.hpp"
+#include "list_view.hpp"
+
+#define WHEEL_ROWS  3
+
+
+list_view::list_view(int X, int Y, int W, int H, int mode)
+ : Fl_Group(X, Y, W, H),
+   items_(NULL),
+   count_(0),
+   rows_(NULL),
+   row_count_(0),
+   filtered_(false),
+   unchecked_(""),
+   checked_(""),
+   empty_(NULL),
+   textfont_(FL_HELVETICA),
+   textsize_(FL_NORMAL_SIZE),
+   top_(0),
+   current_(0),
+   radio_(-1),
+   mode_(mode)
+{
+  box(FL_DOWN_BOX);
+  color(FL_BACKGROUND2_COLOR);
+
+  vscroll_ = new Fl_Scrollbar(0, 0, 0, 0);
+  vscroll_->callback(vscroll_cb, this);
+  vscroll_->clear_visible_focus();
+
+  end();
+  resize(X, Y, W, H);
+}
+
+void list_view::items(const str_view *items, size_t count)
+{
+  items_ = items;
+  count_ = count;
+  bits_.assign((count + 63) / 64, 0);
+  radio_ = -1;
+  filter(NULL);
+}
+
+void list_view::grow(const str_view *items, size_t count)
+{
+  items_ = items;
+  count_ = count;
+  bits_.resize((count + 63) / 64, 0);
+
+  if (!filtered_) {
+    row_count_ = count;
+  }
+  update_scrollbar();
+  redraw();
+}
+
+void list_view::filter(const std::vector<uint32_t> *rows, bool keep_position)
+{
+  filtered_ = (rows != NULL);
+  rows_ = (rows && !rows->empty()) ? &(*rows)[0] : NULL;
+  row_count_ = rows ? rows->size() : count_;
+
+  if (!keep_position) {
+    top_ = current_ = 0;
+  } else if (current_ >= row_count_) {
+    current_ = (row_count_ > 0) ? row_count_ - 1 : 0;
+  }
+  scroll_to(top_);
+}
+
+void list_view::checked(size_t i, bool b)
+{
+  if (b) {
+    bits_[i / 64] |= UINT64_C(1) << (i % 64);
+  } else {
+    bits_[i / 64] &= ~(UINT64_C(1) << (i % 64));
+  }
+}
+
+void list_view::check_all()
+{
+  if (bits_.empty()) {
+    return;
+  }
+
+  memset(&bits_[0], 0xff, bits_.size() * sizeof(uint64_t));
+
+  /* keep the unused bits of the last word clear for count_checked() */
+  if (size() % 64) {
+    bits_.back() = (UINT64_C(1) << (size() % 64)) - 1;
+  }
+  redraw();
+}
+
+void list_view::check_none()
+{
+  if (!bits_.empty()) {
+    memset(&bits_[0], 0, bits_.size() * sizeof(uint64_t));
+  }
+  radio_ = -1;
+  redraw();
+}
+
+size_t list_view::count_checked() const
+{
+  size_t n = 0;
+
+  for (size_t i = 0; i < bits_.size(); ++i) {
+    n += __builtin_popcountll(bits_[i]);
+  }
+  return n;
+}
+
+int list_view::row_height() const
+{
+  fl_font(textfont_, textsize_);
+  return fl_height() + 2;
+}
+
+int list_view::visible_rows() const
+{
+  int n = (h() - Fl::box_dh(box())) / row_height();
+  return (n > 0) ? n : 1;
+}
+
+void list_view::resize(int X, int Y, int W, int H)
+{
+  int sb = Fl::scrollbar_size();
+
+  Fl_Widget::resize(X, Y, W, H);
+  vscroll_->resize(X + W - Fl::box_dw(box()) + Fl::box_dx(box()) - sb, Y + Fl::box_dy(box()),
+                   sb, H - Fl::box_dh(box()));
+  scroll_to(top_);
+}
+
+void list_view::update_scrollbar()
+{
+  vscroll_->value(static_cast<int>(top_), visible_rows(), 0, static_cast<int>(rows()));
+  vscroll_->linesize(1);
+}
+
+void list_view::scroll_to(size_t top)
+{
+  size_t vis = visible_rows();
+  size_t max = (rows() > vis) ? rows() - vis : 0;
+
+  top_ = (top > max) ? max : top;
+  update_scrollbar();
+  redraw();
+}
+
+void list_view::show_row(size_t i)
+{
+  size_t vis = visible_rows();
+
+  current_ = i;
+
+  if (i < top_) {
+    scroll_to(i);
+  } else if (i >= top_ + vis) {
+    scroll_to(i - vis + 1);
+  } else {
+    redraw();
+  }
+}
+
+void list_view::toggle(size_t i)
+{
+  if (mode_ == RADIO) {
+    if (radio_ >= 0) {
+      checked(radio_, false);
+    }
+    checked(i, true);
+    radio_ = i;
+  } else {
+    checked(i, !checked(i));
+  }
+
+  redraw();
+  do_callback();
+}
+
+void list_view::vscroll_cb(Fl_Widget *, void *v)
+{
+  list_view *o = reinterpret_cast<list_view *>(v);
+  o->top_ = o->vscroll_->value();
+  o->redraw();
+}
+
+void list_view::draw()
+{
+  int X = x() + Fl::box_dx(box());
+  int Y = y() + Fl::box_dy(box());
+  int W = w() - Fl::box_dw(box()) - Fl::scrollbar_size();
+  int H = h() - Fl::box_dh(box());
+  int rh = row_height();
+  int sym_w = (*checked_ || *unchecked_) ? textsize_ + 4 : 0;
+  Fl_Color fg = active_r() ? FL_FOREGROUND_COLOR : fl_inactive(FL_FOREGROUND_COLOR);
+
+  draw_box();
+  fl_push_clip(X, Y, W, H);
+
+  for (size_t i = top_; i < rows(); ++i) {
+    int ry = Y + static_cast<int>(i - top_) * rh;
+
+    if (ry >= Y + H) {
+      break;
+    }
+
+    int baseline = ry + rh - fl_descent() - 1;
+    Fl_Color col = fg;
+
+    /* lists that never get the focus are navigated from elsewhere */
+    if (i == current_ && (Fl::focus() == this || !visible_focus())) {
+      fl_color(selection_color());
+      fl_rectf(X, ry, W, rh);
+      col = fl_contrast(fg, selection_color());
+    }
+
+    fl_color(col);
+    fl_font(FL_HELVETICA, textsize_);
+    fl_draw(checked(item(i)) ? checked_ : unchecked_, X + 2, baseline);
+
+    fl_font(textfont_, textsize_);
+    const str_view &v = items_[item(i)];
+
+    if (v.len == 0 && empty_) {
+      fl_draw(empty_, X + 2 + sym_w, baseline);
+    } else {
+      fl_draw(v.data, static_cast<int>(v.len), X + 2 + sym_w, baseline);
+    }
+  }
+
+  fl_pop_clip();
+  draw_child(*vscroll_);
+}
+
+int list_view::handle_key(int key)
+{
+  size_t vis = visible_rows();
+
+  if (rows() == 0) {
+    return 0;
+  }
+
+  switch (key) {
+    case FL_Up:
+      show_row(current_ > 0 ? current_ - 1 : 0);
+      return 1;
+    case FL_Down:
+      show_row(current_ + 1 < rows() ? current_ + 1 : rows() - 1);
+      return 1;
+    case FL_Page_Up:
+      show_row(current_ > vis ? current_ - vis : 0);
+      return 1;
+    case FL_Page_Down:
+      show_row(current_ + vis < rows() ? current_ + vis : rows() - 1);
+      return 1;
+    case FL_Home:
+      show_row(0);
+      return 1;
+    case FL_End:
+      show_row(rows() - 1);
+      return 1;
+    case ' ':
+      toggle(item(current_));
+      return 1;
+  }
+
+  return 0;
+}
+
+int list_view::handle(int event)
+{
+  if (Fl_Group::handle(event)) {
+    return 1;
+  }
+
+  switch (event) {
+    case FL_FOCUS:
+    case FL_UNFOCUS:
+      redraw();
+      return 1;
+
+    case FL_PUSH: {
+        size_t i = top_ + (Fl::event_y() - y() - Fl::box_dy(box())) / row_height();
+
+        take_focus();
+
+        if (i < rows()) {
+          show_row(i);
+          toggle(item(i));
+        }
+      }
+      return 1;
+
+    case FL_MOUSEWHEEL:
+      if (Fl::event_dy() < 0) {
+        size_t n = -Fl::event_dy() * WHEEL_ROWS;
+        scroll_to(top_ > n ? top_ - n : 0);
+      } else if (Fl::event_dy() > 0) {
+        scroll_to(top_ + Fl::event_dy() * WHEEL_ROWS);
+      }
+      return 1;
+
+    case FL_KEYBOARD:
+      return handle_key(Fl::event_key());
+  }
+
+  return 0;
+}
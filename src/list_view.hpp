@@ -0,0 +1,135 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LIST_VIEW_HPP
+#define LIST_VIEW_HPP
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fltk-dialog.hpp"
+
+
+/* A list of checkable items for the checklist and radiolist dialogs.
+ * The item texts are views into an option_list that must outlive the
+ * widget and the check states are kept in a bitset, so nothing is copied
+ * or allocated per item, and only the visible rows are drawn.  Items are
+ * numbered from 0. */
+class list_view : public Fl_Group
+{
+public:
+  enum {
+    CHECK,  /* any number of items can be checked */
+    RADIO   /* checking an item unchecks the previous one */
+  };
+
+  list_view(int X, int Y, int W, int H, int mode = CHECK);
+
+  /* the array isn't copied */
+  void items(const str_view *items, size_t count);
+
+  /* the same items with more at the end, possibly moved; states, the
+   * scroll position and the filter are kept */
+  void grow(const str_view *items, size_t count);
+
+  /* Shows only the given items, in that order, or all items if rows is
+   * NULL.  The vector isn't copied.  Check states are kept, the scroll
+   * position only if keep_position is true. */
+  void filter(const std::vector<uint32_t> *rows, bool keep_position = false);
+
+  size_t size() const { return count_; }
+  size_t rows() const { return row_count_; }
+  const str_view &text(size_t i) const { return items_[i]; }
+
+  bool checked(size_t i) const { return (bits_[i / 64] >> (i % 64)) & 1; }
+  void checked(size_t i, bool b);
+
+  /* O(n/64) */
+  void check_all();
+  void check_none();
+  size_t count_checked() const;
+
+  /* the checked item in RADIO mode, -1 if none */
+  long value() const { return radio_; }
+
+  /* the item in the current (highlighted) row, -1 if no row is shown */
+  long current() const { return (current_ < rows()) ? static_cast<long>(item(current_)) : -1; }
+
+  /* makes a row current and scrolls it into view */
+  void show_row(size_t row);
+
+  /* the symbols drawn in front of unchecked and checked items */
+  void symbols(const char *unchecked, const char *checked) {
+    unchecked_ = unchecked;
+    checked_ = checked;
+  }
+
+  /* drawn instead of empty items; NULL draws nothing */
+  void empty_text(const char *s) { empty_ = s; }
+
+  Fl_Font textfont() const { return textfont_; }
+  void textfont(Fl_Font f) { textfont_ = f; }
+
+  Fl_Fontsize textsize() const { return textsize_; }
+  void textsize(Fl_Fontsize s) { textsize_ = s; }
+
+  /* Moves the current row with Up, Down, Page Up/Down, Home and End and
+   * toggles it with Space; returns 1 if the key was used.  Can be called
+   * from another widget that keeps the keyboard focus. */
+  int handle_key(int key);
+
+  int handle(int event);
+  void resize(int X, int Y, int W, int H);
+
+protected:
+  void draw();
+
+private:
+  Fl_Scrollbar *vscroll_;
+  const str_view *items_;
+  size_t count_;
+  const uint32_t *rows_;
+  size_t row_count_;
+  bool filtered_;
+  std::vector<uint64_t> bits_;
+  const char *unchecked_, *checked_;
+  const char *empty_;
+  Fl_Font textfont_;
+  Fl_Fontsize textsize_;
+  size_t top_, current_;
+  long radio_;
+  int mode_;
+
+  int row_height() const;
+  int visible_rows() const;
+  void scroll_to(size_t top);
+  size_t item(size_t row) const { return rows_ ? rows_[row] : row; }
+  void update_scrollbar();
+  void toggle(size_t i);
+
+  static void vscroll_cb(Fl_Widget *, void *v);
+};
+
+#endif  /* !LIST_VIEW_HPP */
@@ -31,12 +31,16 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include "fltk-dialog.hpp"
-#include "icon_png.h"
+#include "trace.hpp"
+#include "icon_rgba.h"
 
 typedef args::Flag ARG_T;
 typedef args::ValueFlag<int> ARGI_T;
@@ -73,6 +77,36 @@ static void measure_cb(const Fl_Label *o, int &w, int &h) {
   fl_measure(o->value, w, h, 0);
 }
 
+/* parse a size with an optional K, M, G or T suffix */
+static bool parse_size(const char *s, uint64_t &size)
+{
+  char *end = NULL;
+  int shift = 0;
+
+  errno = 0;
+  size = strtoull(s, &end, 10);
+
+  if (errno != 0 || end == s || s[0] == '-') {
+    return false;
+  }
+
+  switch (toupper(*end)) {
+    case '\0': break;
+    case 'K': shift = 10; break;
+    case 'M': shift = 20; break;
+    case 'G': shift = 30; break;
+    case 'T': shift = 40; break;
+    default: return false;
+  }
+
+  if (*end != '\0' && end[1] != '\0' && strcasecmp(end + 1, "iB") != 0 && strcasecmp(end + 1, "B") != 0) {
+    return false;
+  }
+
+  size <<= shift;
+  return true;
+}
+
 static int esc_handler(int event) {
   if (event == FL_SHORTCUT && Fl::event_key() == FL_Escape) {
     return 1; /* ignore Escape key */
@@ -80,13 +114,15 @@ static int esc_handler(int event) {
   return 0;
 }
 
-int main(int argc, char **argv)
+static int run_dialog(int argc, char **argv)
 {
+  uint64_t t = trace_now();
+
   if (argc < 2) {
     Fl::scheme("gtk+");
     Fl::visual(FL_DOUBLE|FL_INDEX);
     Fl::set_color(FL_BACKGROUND_COLOR, fl_lighter(FL_BACKGROUND_COLOR));
-    Fl_Window::default_icon(new Fl_PNG_Image(NULL, icon_png, icon_png_len));
+    Fl_Window::default_icon(rgba_image(icon_rgba));
     l10n();
     override_pos = 5;
     return about();
@@ -98,7 +134,21 @@ int main(int argc, char **argv)
   args::Group ap(ap_main, "Generic options:");
   args::HelpFlag help(ap, "help", "Show options", {'h', "help"});
   ARG_T  arg_version(ap, "version", "Show FLTK and program version", {'v', "version"})
-  ,      arg_about(ap, "about", "About FLTK dialog", {"about"});
+  ,      arg_about(ap, "about", "About FLTK dialog", {"about"})
+  ,      arg_daemon(ap, "daemon", "Run a dialog server that other invocations hand their dialogs to; the server "
+                    "does process startup and font configuration once, the X connection is still opened for "
+                    "every dialog; must be the only option; the socket is $FLTK_DIALOG_SOCKET, "
+                    "$XDG_RUNTIME_DIR/fltk-dialog.sock or /tmp/fltk-dialog-UID.sock; set FLTK_DIALOG_NO_DAEMON to "
+                    "bypass the server", {"daemon"});
+  ARGS_T arg_batch(ap, "FILE", "Run the dialogs listed in FILE (or stdin if FILE is `-') one after another, "
+                   "each forked from the same process; every line holds the options of one dialog, quoted like in "
+                   "a shell or as a JSON array of strings; the output of each dialog is printed as a JSON record; "
+                   "all dialogs are run and the exit code of the last one is returned; must be the only option "
+                   "besides --batch-stop", {"batch"});
+  ARG_T  arg_batch_stop(ap, "batch-stop", "With --batch: stop at the first dialog that doesn't return 0 "
+                        "(e.g. a \"No\" to --question) and return its exit code", {"batch-stop"});
+  ARGS_T arg_trace_startup(ap, "FILE", "Measure the startup phases and print them to stderr if FILE is `-', "
+                           "otherwise write them to FILE as Chrome trace-event JSON", {"trace-startup"});
   ARGS_T arg_text(ap, "TEXT", "Set the dialog text", {"text"})
   ,      arg_title(ap, "TEXT", "Set the dialog title", {"title"})
   ,      arg_ok_label(ap, "TEXT", "Set the OK button text", {"ok-label"})
@@ -144,11 +194,15 @@ int main(int argc, char **argv)
   ,      arg_color(ap, "color", "Display color selection dialog; returns color as \"RGB [0.000-1.000]|RGB "
                    "[0-255]|HTML hex|HSV\"", {"color"})
   ,      arg_scale(ap, "scale", "Display scale dialog", {"scale"});
-  ARGS_T arg_checklist(ap, "OPT1|OPT2[|..]", "Display a check button list", {"checklist"})
-  ,      arg_radiolist(ap, "OPT1|OPT2[|..]", "Display a radio button list", {"radiolist"})
-  ,      arg_dropdown(ap, "OPT1|OPT2[|..]", "Display a dropdown menu", {"dropdown"})
+  ARGS_T arg_checklist(ap, "OPT1|OPT2[|..]", "Display a check button list; use `-' to read the options from stdin "
+                       "or --options-file", {"checklist"})
+  ,      arg_radiolist(ap, "OPT1|OPT2[|..]", "Display a radio button list; use `-' to read the options from stdin "
+                       "or --options-file", {"radiolist"})
+  ,      arg_dropdown(ap, "OPT1|OPT2[|..]", "Display a dropdown menu; use `-' to read the options from stdin or "
+                      "--options-file", {"dropdown"})
   ,      arg_html(ap, "FILE", "Display HTML viewer", {"html"});
-  ARG_T  arg_text_info(ap, "text-info", "Display text information dialog", {"text-info"})
+  ARG_T  arg_list(ap, "list", "Display a list with one or more columns", {"list"})
+  ,      arg_text_info(ap, "text-info", "Display text information dialog", {"text-info"})
   ,      arg_notification(ap, "notification", "Display a notification pop-up", {"notification"});
   ARGS_T arg_indicator(ap, "COMMAND", "create an indicator/tray entry as a launcher for a given command; "
                        "use --text to set a tooltip message", {"indicator"});
@@ -181,13 +235,34 @@ int main(int argc, char **argv)
   ARG_T  arg_pulsate(g_progress_options, "pulsate", "Pulsating progress bar", {"pulsate"});
   ARGI_T arg_multi(g_progress_options, "NUMBER", "Use 2 progress bars; the main bar, showing the overall progress, "
                    "will reach 100% if the other bar has reached 100% after NUMBER iterations", {"multi"});
-  ARGL_T arg_watch_pid(g_progress_options, "PID", "Process ID to watch", {"watch-pid"});
+  ARGL_T arg_watch_pid(g_progress_options, "PID", "Process ID to watch; the progress is finished when the process "
+                       "terminates and it receives SIGHUP if the dialog is canceled", {"watch-pid"});
+  ARGI_T arg_watch_fd(g_progress_options, "FD", "Derive the progress from the file offset of the file descriptor "
+                      "FD of the process given by --watch-pid and show throughput and remaining time; nothing is "
+                      "read from stdin", {"watch-fd"});
+  ARG_T  arg_pipe(g_progress_options, "pipe", "Copy stdin to stdout and show the amount of data passed through, "
+                  "the throughput and the remaining time (if --size was given)", {"pipe"});
+  ARGS_T arg_size(g_progress_options, "SIZE", "Expected size of the data passed through with --pipe; the suffixes "
+                  "K, M, G and T are supported", {"size"});
+  ARGS_T arg_listen(g_progress_options, "PATH", "Read input from a Unix socket (will be created if needed) instead "
+                    "of stdin; every connection is parsed on its own and the progress of all connections is merged; "
+                    "if PATH is a named pipe it is read as a single shared input", {"listen"});
+  ARGS_T arg_shm(g_progress_options, "NAME", "Create a shared memory segment NAME (see shm_open(3)) with "
+                 "\"done\" and \"total\" counters and a label that producers update directly (see "
+                 "progress_shm.h); NAME must not exist yet; if NAME is `-' an anonymous segment is created and "
+                 "its path is printed",
+                 {"shm"});
 
   args::Group g_progress_text_info_options(ap_main, "Progress/text information options:");
   ARG_T  arg_auto_close(g_progress_text_info_options, "auto-close", "Automatically close the dialog window",
                         {"auto-close"})
   ,      arg_no_cancel(g_progress_text_info_options, "no-cancel", "Hide cancel button", {"no-cancel"});
 
+  args::Group g_list_options(ap_main, "Checklist/radiolist/dropdown options:");
+  ARGS_T arg_options_file(g_list_options, "FILE", "Read the options from FILE if the option list is `-'; the "
+                          "options are separated by newlines unless --separator is given (results are still printed "
+                          "separated by --separator or `|')", {"options-file"});
+
   args::Group g_checklist_options(ap_main, "Checklist options:");
   ARG_T  arg_check_all(g_checklist_options, "check-all", "Start with all items selected", {"check-all"})
   ,      arg_return_value(g_checklist_options, "return-value", "Return list of selected items instead of a "
@@ -197,6 +272,17 @@ int main(int argc, char **argv)
   ARG_T  arg_return_number(g_radiolist_dropdown_options, "return-number", "Return selected entry number instead of "
                            "label text", {"return-number"});
 
+  args::Group g_list_dialog_options(ap_main, "List options:");
+  args::ValueFlagList<std::string> arg_column(g_list_dialog_options, "NAME", "Add a column with the header NAME; "
+                                              "required at least once", {"column"});
+  ARG_T  arg_multiple(g_list_dialog_options, "multiple", "Allow selecting multiple rows", {"multiple"})
+  ,      arg_csv(g_list_dialog_options, "csv", "Read comma separated instead of tab separated rows from stdin",
+                 {"csv"});
+  ARGS_T arg_print_column(g_list_dialog_options, "N", "Print the values of column N of the selected rows, or of all "
+                          "columns if N is ALL; default is 1", {"print-column"});
+  args::PositionalList<std::string> arg_cells(g_list_dialog_options, "CELL", "The cells of the list, row by row; "
+                                              "if none are given the rows are read from stdin");
+
   args::Group g_calendar_options(ap_main, "Calendar/date options:");
   ARGS_T arg_format(g_calendar_options, "FORMAT",
                     "Set a custom output using glibc date formats; interpreted sequences for FORMAT are:\n"
@@ -223,6 +309,14 @@ int main(int argc, char **argv)
   ARGS_T arg_checkbox(g_text_info_options, "TEXT", "Enable an \"I read and agree\" checkbox", {"checkbox"});
   ARG_T  arg_auto_scroll(g_text_info_options, "auto-scroll", "Always scroll to the bottom of the text",
                          {"auto-scroll"});
+  ARGS_T arg_filename(g_text_info_options, "FILE", "Display the contents of FILE instead of reading from stdin",
+                      {"filename"});
+  ARG_T  arg_follow(g_text_info_options, "follow", "Keep reading data appended to the file given by --filename, "
+                    "like `tail -F'", {"follow"});
+  ARGL_T arg_max_lines(g_text_info_options, "N", "Keep only the last N lines read from stdin or with --follow",
+                       {"max-lines"});
+  ARGS_T arg_max_bytes(g_text_info_options, "SIZE", "Keep only the last SIZE bytes of text read from stdin or with "
+                       "--follow; the suffixes K, M, G and T are supported", {"max-bytes"});
 
   args::Group g_notification_options(ap_main, "Notification options:");
   ARGI_T arg_timeout(g_notification_options, "SECONDS", "Set the timeout value for the notification in seconds",
@@ -242,9 +336,9 @@ int main(int argc, char **argv)
   ,     unused_arg3(g_indicator_options, "native-qt", "Use the Qt5 indicator", {"native-qt"});
 #endif
 #endif  /* USE_DLOPEN */
-  ARGS_T arg_listen(g_indicator_options, "PATH", "Listen for input from a named pipe (will be created if needed); "
-                    "the following commands are available: run icon:<nameOfIcon> quit",
-                    {"listen"});
+  ARGS_T unused_arg5(g_indicator_options, "PATH", "Listen for input from a named pipe (will be created if needed); "
+                     "the following commands are available: run icon:<nameOfIcon> quit",
+                     {"listen"});
   ARG_T unused_arg4(g_indicator_options, "auto-close", "Remove the indicator icon when the command was run",
                      {"auto-close"});
 
@@ -266,11 +360,41 @@ int main(int argc, char **argv)
     return 1;
   }
 
+  trace_span("parse arguments", t);
+
   if (arg_version) {
     std::cout << fltk_using << std::endl;
     return 0;
   }
 
+  if (arg_daemon) {
+    std::cerr << argv[0] << ": `--daemon' must be the only option" << std::endl;
+    return 1;
+  }
+
+  if (arg_batch) {
+    /* `--batch FILE' is two arguments */
+    int expected = 2 + (arg_batch_stop ? 1 : 0);
+
+    for (int i = 1; i < argc; ++i) {
+      if (strcmp(argv[i], "--batch") == 0) {
+        expected++;
+        break;
+      }
+    }
+
+    if (argc != expected) {
+      std::cerr << argv[0] << ": `--batch' can only be combined with `--batch-stop'" << std::endl;
+      return 1;
+    }
+    return dialog_batch(argv[0], args::get(arg_batch).c_str(), arg_batch_stop, run_dialog);
+  }
+
+  if (arg_batch_stop) {
+    std::cerr << argv[0] << ": `--batch-stop' requires `--batch'" << std::endl;
+    return 1;
+  }
+
   if (arg_message +
       arg_warning +
       arg_error +
@@ -288,6 +412,7 @@ int main(int argc, char **argv)
       arg_checklist +
       arg_radiolist +
       arg_dropdown +
+      arg_list +
       arg_html +
       arg_text_info +
       arg_notification +
@@ -307,7 +432,9 @@ int main(int argc, char **argv)
 
   /* do the localization BEFORE we set
    * the user-specified button labels */
+  t = trace_now();
   l10n();
+  trace_span("l10n", t);
 
   window_decoration = arg_undecorated ? false : true;
   window_taskbar = arg_skip_taskbar ? false : true;
@@ -454,6 +581,10 @@ int main(int argc, char **argv)
   /* progress */
   int multi = 1;
   long kill_pid = -1;
+  int watch_fd = -1;
+  uint64_t pipe_size = 0;
+  const char *listen_path = NULL;
+  const char *shm_name = NULL;
   if (arg_progress) {
     dialog = DIALOG_PROGRESS;
 
@@ -462,7 +593,64 @@ int main(int argc, char **argv)
       return 1;
     }
 
+    if (arg_listen) {
+      listen_path = args::get(arg_listen).c_str();
+
+      if (strlen(listen_path) == 0) {
+        std::cerr << argv[0] << ": error `--listen': empty string" << std::endl;
+        return 1;
+      }
+
+      if (arg_multi) {
+        std::cerr << argv[0] << ": cannot use `--multi' and `--listen' together" << std::endl;
+        return 1;
+      }
+    }
+
+    if (arg_shm) {
+      shm_name = args::get(arg_shm).c_str();
+
+      if (strlen(shm_name) == 0) {
+        std::cerr << argv[0] << ": error `--shm': empty string" << std::endl;
+        return 1;
+      }
+
+      if (arg_multi) {
+        std::cerr << argv[0] << ": cannot use `--multi' and `--shm' together" << std::endl;
+        return 1;
+      }
+    }
+
+    if (arg_watch_fd) {
+      if (!arg_watch_pid) {
+        std::cerr << argv[0] << ": `--watch-fd' requires `--watch-pid'" << std::endl;
+        return 1;
+      }
+
+      if (arg_pulsate || arg_multi) {
+        std::cerr << argv[0] << ": cannot use `--watch-fd' together with `--pulsate' or `--multi'" << std::endl;
+        return 1;
+      }
+    }
+
+    if (arg_pipe) {
+      if (arg_pulsate || arg_multi || arg_listen || arg_shm || arg_watch_fd) {
+        std::cerr << argv[0] << ": cannot use `--pipe' together with `--pulsate', `--multi', `--listen', "
+          "`--shm' or `--watch-fd'" << std::endl;
+        return 1;
+      }
+
+      if (arg_size && !parse_size(args::get(arg_size).c_str(), pipe_size)) {
+        std::cerr << argv[0] << ": error `--size': invalid size" << std::endl;
+        return 1;
+      }
+    } else if (arg_size) {
+      std::cerr << argv[0] << ": `--size' requires `--pipe'" << std::endl;
+      return 1;
+    }
+
     GETVAL(kill_pid, arg_watch_pid);
+    GETVAL(watch_fd, arg_watch_fd);
     GETVAL(multi, arg_multi);
     multi = (multi > 1) ? multi : 1;
   }
@@ -484,25 +672,66 @@ int main(int argc, char **argv)
     }
   }
 
-  /* checklist */
-  std::string checklist_options = "";
+  /* checklist / radiolist / dropdown */
+  option_list options;
+  std::string options_arg = "";
   if (arg_checklist) {
     dialog = DIALOG_CHECKLIST;
-    GETVAL(checklist_options, arg_checklist);
+    GETVAL(options_arg, arg_checklist);
+  } else if (arg_radiolist) {
+    dialog = DIALOG_RADIOLIST;
+    GETVAL(options_arg, arg_radiolist);
+  } else if (arg_dropdown) {
+    dialog = DIALOG_DROPDOWN;
+    GETVAL(options_arg, arg_dropdown);
   }
 
-  /* radiolist */
-  std::string radiolist_options = "";
-  if (arg_radiolist) {
-    dialog = DIALOG_RADIOLIST;
-    GETVAL(radiolist_options, arg_radiolist);
+  if (options_arg == "-") {
+    const char *file = "-";
+    GETCSTR(file, arg_options_file);
+
+    /* files are usually one option per line; this only affects how the
+     * input is split, results are still printed with `separator' */
+    char input_separator = arg_separator ? separator : '\n';
+
+    if (!options.load_file(file, input_separator)) {
+      return 1;
+    }
+  } else if (arg_options_file) {
+    std::cerr << argv[0] << ": `--options-file' requires `--checklist=-', `--radiolist=-' or `--dropdown=-'"
+      << std::endl;
+    return 1;
+  } else {
+    options.load_string(options_arg, separator);
   }
 
-  /* dropdown */
-  std::string dropdown_options = "";
-  if (arg_dropdown) {
-    dialog = DIALOG_DROPDOWN;
-    GETVAL(dropdown_options, arg_dropdown);
+  /* list */
+  int print_column = 1;
+  if (arg_list) {
+    dialog = DIALOG_LIST;
+
+    if (!arg_column) {
+      std::cerr << argv[0] << ": `--list' requires at least one `--column'" << std::endl;
+      return 1;
+    }
+
+    if (arg_print_column) {
+      std::string s = args::get(arg_print_column);
+      char *end;
+      long l = strtol(s.c_str(), &end, 10);
+
+      if (strcasecmp(s.c_str(), "ALL") == 0) {
+        print_column = 0;
+      } else if (s.empty() || *end != '\0' || l < 1 || l > static_cast<long>(args::get(arg_column).size())) {
+        std::cerr << argv[0] << ": error `--print-column': must be ALL or a column number" << std::endl;
+        return 1;
+      } else {
+        print_column = l;
+      }
+    }
+  } else if (arg_cells) {
+    std::cerr << argv[0] << ": unexpected argument `" << args::get(arg_cells).front() << "'" << std::endl;
+    return 1;
   }
 
   /* calendar / date */
@@ -516,15 +745,45 @@ int main(int argc, char **argv)
   }
 
   /* text-info */
-  const char *checkbox = NULL;
+  const char *checkbox = NULL, *filename = NULL;
+  long max_lines = 0;
+  uint64_t max_bytes = 0;
   if (arg_text_info) {
     dialog = DIALOG_TEXTINFO;
     GETCSTR(checkbox, arg_checkbox);
+    GETCSTR(filename, arg_filename);
+    GETVAL(max_lines, arg_max_lines);
 
     if (arg_checkbox && arg_auto_close) {
       std::cerr << argv[0] << ": cannot use `--checkbox' and `--auto-close' together" << std::endl;
       return 1;
     }
+
+    if (arg_follow) {
+      if (!arg_filename) {
+        std::cerr << argv[0] << ": `--follow' requires `--filename'" << std::endl;
+        return 1;
+      }
+
+      if (arg_auto_close) {
+        std::cerr << argv[0] << ": cannot use `--follow' and `--auto-close' together" << std::endl;
+        return 1;
+      }
+    } else if (arg_filename && (arg_max_lines || arg_max_bytes)) {
+      std::cerr << argv[0] << ": `--max-lines' and `--max-bytes' require `--follow' when used with `--filename'"
+        << std::endl;
+      return 1;
+    }
+
+    if (arg_max_lines && max_lines < 1) {
+      std::cerr << argv[0] << ": error `--max-lines': value must be 1 or higher" << std::endl;
+      return 1;
+    }
+
+    if (arg_max_bytes && (!parse_size(args::get(arg_max_bytes).c_str(), max_bytes) || max_bytes == 0)) {
+      std::cerr << argv[0] << ": error `--max-bytes': invalid size" << std::endl;
+      return 1;
+    }
   }
 
   /* keep fltk's '@' symbols enabled for HTML, date and calendar dialogs */
@@ -532,7 +791,16 @@ int main(int argc, char **argv)
     Fl::set_labeltype(FL_NORMAL_LABEL, draw_cb, measure_cb);
   }
 
+  /* the display is opened implicitly later on, but
+   * for the trace it should be a phase on its own */
+  if (trace_enabled()) {
+    t = trace_now();
+    fl_open_display();
+    trace_span("open display", t);
+  }
+
   /* set scheme */
+  t = trace_now();
   const char *scheme = "gtk+";
   GETCSTR(scheme, arg_scheme);
 
@@ -550,22 +818,27 @@ int main(int argc, char **argv)
   } else {
     Fl::scheme("gtk+");
   }
+  trace_span("scheme", t);
 
   /* set window icon and system colors */
   const char *icon = NULL;
   GETCSTR(icon, arg_icon);
 
   if (!arg_notification) {
+    t = trace_now();
     Fl_RGB_Image *rgb = img_to_rgb(icon);
+    trace_span("img_to_rgb", t);
 
     if (!rgb) {
-      rgb = new Fl_PNG_Image(NULL, icon_png, icon_png_len);
+      rgb = rgba_image(icon_rgba);
     }
 
     Fl_Window::default_icon(rgb);
 
     if (arg_system_colors) {
+      t = trace_now();
       Fl::get_system_colors();
+      trace_span("system colors", t);
     } else {
       /* make default colors a bit lighter */
       Fl::set_color(FL_BACKGROUND_COLOR, fl_lighter(FL_BACKGROUND_COLOR));
@@ -580,6 +853,8 @@ int main(int argc, char **argv)
     Fl::add_handler(esc_handler);
   }
 
+  trace_dialog_start();
+
   switch (dialog) {
     case DIALOG_ABOUT:
       break;
@@ -604,15 +879,19 @@ int main(int argc, char **argv)
     case DIALOG_NOTIFY:
       return dialog_notify(argv[0], timeout, icon, arg_libnotify);
     case DIALOG_PROGRESS:
-      return dialog_progress(arg_pulsate, multi, kill_pid, arg_auto_close, arg_no_cancel);
+      return dialog_progress(arg_pulsate, multi, kill_pid, watch_fd, arg_auto_close, arg_no_cancel, listen_path, shm_name,
+                             arg_pipe, pipe_size);
     case DIALOG_TEXTINFO:
-      return dialog_textinfo(arg_auto_scroll, checkbox, arg_auto_close, arg_no_cancel);
+      return dialog_textinfo(arg_auto_scroll, checkbox, arg_auto_close, arg_no_cancel, filename, arg_follow, max_lines,
+                             max_bytes);
     case DIALOG_CHECKLIST:
-      return dialog_checklist(checklist_options, arg_return_value, arg_check_all, separator);
+      return dialog_checklist(options, arg_return_value, arg_check_all, separator);
     case DIALOG_RADIOLIST:
-      return dialog_radiolist(radiolist_options, arg_return_number, separator);
+      return dialog_radiolist(options, arg_return_number);
     case DIALOG_DROPDOWN:
-      return dialog_dropdown(dropdown_options, arg_return_number, separator);
+      return dialog_dropdown(options, arg_return_number);
+    case DIALOG_LIST:
+      return dialog_list(args::get(arg_column), args::get(arg_cells), arg_multiple, print_column, arg_csv, separator);
     case DIALOG_CALENDAR:
       return dialog_calendar(format);
     case DIALOG_DATE:
@@ -634,3 +913,19 @@ int main(int argc, char **argv)
   return about();
 }
 
+int main(int argc, char **argv)
+{
+  int rv;
+
+  if (argc == 2 && strcmp(argv[1], "--daemon") == 0) {
+    return daemon_main(argv[0], run_dialog);
+  }
+
+  if (daemon_client(argc, argv, rv)) {
+    return rv;
+  }
+
+  trace_init(argc, argv);
+
+  return run_dialog(argc, argv);
+}
@@ -28,12 +28,16 @@
 #include <string>
 #include <vector>
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #if defined(HAVE_QT) && defined(USE_DLOPEN)
 # include <dlfcn.h>
@@ -43,6 +47,7 @@
 #endif
 
 #include "fltk-dialog.hpp"
+#include "trace.hpp"
 #include "../random/include/effolkronium/random.hpp"
 
 bool always_on_top = false;
@@ -362,6 +367,62 @@ bool save_to_temp(const unsigned char *data, const unsigned int data_len, const
   return true;
 }
 
+/* Copies the data into a sealed memfd; `path' is set to the /proc/self/fd
+ * path of it, which stays valid until the returned descriptor is closed.
+ * Returns -1 on error. */
+int save_to_memfd(const unsigned char *data, const unsigned int data_len, const char *name, std::string &path)
+{
+  const char *p = reinterpret_cast<const char *>(data);
+  size_t len = data_len;
+  ssize_t n;
+  int fd;
+
+  if ((fd = create_memfd(name, MFD_CLOEXEC|MFD_ALLOW_SEALING)) == -1) {
+    return -1;
+  }
+
+  while (len > 0) {
+    if ((n = write(fd, p, len)) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("write()");
+      close(fd);
+      return -1;
+    }
+    p += n;
+    len -= n;
+  }
+
+  /* make it read-only for good */
+  if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_WRITE|F_SEAL_SEAL) == -1) {
+    perror("fcntl()");
+    close(fd);
+    return -1;
+  }
+
+  path = "/proc/self/fd/" + std::to_string(fd);
+  return fd;
+}
+
+/* memfd_create() wrapper for glibc versions older than 2.27 */
+int create_memfd(const char *name, unsigned int flags)
+{
+#ifdef SYS_memfd_create
+  return syscall(SYS_memfd_create, name, flags);
+#else
+  static_cast<void>(name);
+  static_cast<void>(flags);
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+/* the image uses the pixels in place, nothing is copied or decoded */
+Fl_RGB_Image *rgba_image(const rgba_data &data) {
+  return new Fl_RGB_Image(data.pixels, data.w, data.h, data.d);
+}
+
 /* Optimized algorithm by Kevin P. Rice:
  * https://stackoverflow.com/a/11595914/5687704
  *
@@ -390,11 +451,11 @@ void *dlopen_qtplugin(std::string &plugin, void * &handle, const char *func)
   plugin = std::string(dir) + "/qtplugin.so";
 
   /* RTLD_NODELETE is needed to prevent memory access violation on dlclose() */
-  handle = dlopen(plugin.c_str(), RTLD_LAZY|RTLD_NODELETE);
+  handle = trace_dlopen(plugin.c_str(), RTLD_LAZY|RTLD_NODELETE);
 
   if (!handle) {
     plugin = std::string(dir) + "/../lib/fltk-dialog/qtplugin.so";
-    handle = dlopen(plugin.c_str(), RTLD_LAZY|RTLD_NODELETE);
+    handle = trace_dlopen(plugin.c_str(), RTLD_LAZY|RTLD_NODELETE);
   }
 
   dir = NULL;
@@ -402,10 +463,21 @@ void *dlopen_qtplugin(std::string &plugin, void * &handle, const char *func)
 
 #else
 
-  if (!save_to_temp(qtplugin_so, qtplugin_so_len, ".so", plugin)) {
+  /* load the plugin from memory; a temporary file is only
+   * used if the kernel doesn't support memfd_create() */
+  int fd = save_to_memfd(qtplugin_so, qtplugin_so_len, "qtplugin.so", plugin);
+
+  if (fd == -1 && !save_to_temp(qtplugin_so, qtplugin_so_len, ".so", plugin)) {
     return NULL;
   }
-  handle = dlopen(plugin.c_str(), RTLD_LAZY|RTLD_NODELETE);
+  handle = trace_dlopen(plugin.c_str(), RTLD_LAZY|RTLD_NODELETE);
+
+  /* the mapping stays valid without the file */
+  if (fd == -1) {
+    unlink(plugin.c_str());
+  } else {
+    close(fd);
+  }
 
 #endif  /* USE_EXTERNAL_PLUGINS */
 
@@ -413,9 +485,6 @@ void *dlopen_qtplugin(std::string &plugin, void * &handle, const char *func)
 
   if (!handle) {
     std::cerr << error << std::endl;
-#ifndef USE_EXTERNAL_PLUGINS
-    unlink(plugin.c_str());
-#endif
     return NULL;
   }
 
@@ -428,9 +497,6 @@ void *dlopen_qtplugin(std::string &plugin, void * &handle, const char *func)
   if (error || !func_ptr) {
     std::cerr << "error: " << error << std::endl;
     dlclose(handle);
-#ifndef USE_EXTERNAL_PLUGINS
-    unlink(plugin.c_str());
-#endif
     return NULL;
   }
 
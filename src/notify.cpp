@@ -29,6 +29,7 @@
 #include <unistd.h>
 
 #include "fltk-dialog.hpp"
+#include "trace.hpp"
 #ifdef USE_DLOPEN
 # include "notify.h"
 #endif
@@ -207,7 +208,7 @@ static bool run_libnotify(const char *appname, int timeout, const char *notify_i
 {
   /* dlopen() libnotify */
 
-  void *handle = dlopen("libnotify.so.4", RTLD_LAZY);
+  void *handle = trace_dlopen("libnotify.so.4", RTLD_LAZY);
   char *error = dlerror();
 
   if (!handle) {
@@ -0,0 +1,328 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <iostream>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "line_reader.hpp"
+#include "option_list.hpp"
+
+#define READ_SIZE         (64*1024)
+#define ARENA_CHUNK_SIZE  (1024*1024)
+
+
+text_arena::text_arena()
+ : used_(ARENA_CHUNK_SIZE)
+{
+}
+
+text_arena::~text_arena()
+{
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    free(chunks_[i]);
+  }
+}
+
+const char *text_arena::store(const char *p, size_t len)
+{
+  char *dst;
+
+  if (ARENA_CHUNK_SIZE - used_ < len + 1) {
+    /* oversized strings get a chunk of their own */
+    size_t size = (len + 1 > ARENA_CHUNK_SIZE) ? len + 1 : ARENA_CHUNK_SIZE;
+    char *c = reinterpret_cast<char *>(malloc(size));
+
+    if (!c) {
+      perror("malloc()");
+      exit(1);
+    }
+
+    if (size > ARENA_CHUNK_SIZE) {
+      chunks_.insert(chunks_.end() - (chunks_.empty() ? 0 : 1), c);
+      memcpy(c, p, len);
+      c[len] = '\0';
+      return c;
+    }
+
+    chunks_.push_back(c);
+    used_ = 0;
+  }
+
+  dst = chunks_.back() + used_;
+  memcpy(dst, p, len);
+  dst[len] = '\0';
+  used_ += len + 1;
+
+  return dst;
+}
+
+
+option_list::option_list()
+ : map_(NULL),
+   map_size_(0),
+   fd_(-1),
+   separator_('\n')
+{
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+option_list::~option_list()
+{
+  if (map_) {
+    munmap(const_cast<char *>(map_), map_size_);
+  }
+  pthread_mutex_destroy(&mutex_);
+}
+
+/* files and pipes usually end with a newline even if the options are
+ * separated by something else; drop it so it isn't part of the last
+ * option */
+static size_t strip_final_newline(const char *p, size_t len, char separator)
+{
+  if (separator != '\n' && len > 0 && p[len - 1] == '\n') {
+    len--;
+
+    if (len > 0 && p[len - 1] == '\r') {
+      len--;
+    }
+  }
+  return len;
+}
+
+void option_list::split(const char *p, const char *end, char separator)
+{
+  const char *q;
+
+  if (separator == '\n') {
+    newline_scanner scan(p, end);
+
+    while ((q = scan.next()) != NULL) {
+      str_view v = { p, static_cast<size_t>(q - p) };
+
+      /* CRLF line endings */
+      if (v.len > 0 && v.data[v.len - 1] == '\r') {
+        v.len--;
+      }
+      items_.push_back(v);
+      p = q + 1;
+    }
+  } else {
+    while ((q = reinterpret_cast<const char *>(memchr(p, separator, end - p))) != NULL) {
+      str_view v = { p, static_cast<size_t>(q - p) };
+      items_.push_back(v);
+      p = q + 1;
+    }
+  }
+
+  str_view v = { p, static_cast<size_t>(end - p) };
+
+  if (separator == '\n' && v.len > 0 && v.data[v.len - 1] == '\r') {
+    v.len--;
+  }
+  items_.push_back(v);
+}
+
+void option_list::load_string(std::string &s, char separator)
+{
+  buffer_.swap(s);
+  items_.clear();
+
+  /* behave like split(): no separator means no options */
+  if (buffer_.find(separator) != std::string::npos) {
+    split(buffer_.data(), buffer_.data() + buffer_.size(), separator);
+  }
+}
+
+bool option_list::load_file(const char *file, char separator)
+{
+  struct stat st;
+  bool use_stdin = (strcmp(file, "-") == 0);
+  int fd = use_stdin ? STDIN_FILENO : open(file, O_RDONLY|O_CLOEXEC);
+  const char *p, *end;
+
+  if (fd == -1) {
+    perror("open()");
+    return false;
+  }
+
+  if (fstat(fd, &st) == -1) {
+    perror("fstat()");
+    if (!use_stdin) {
+      close(fd);
+    }
+    return false;
+  }
+
+  /* map regular files (including redirected stdin), stream everything
+   * else */
+  if (S_ISREG(st.st_mode) && st.st_size == 0) {
+    if (!use_stdin) {
+      close(fd);
+    }
+    items_.clear();
+    return true;
+  } else if (S_ISREG(st.st_mode)) {
+    void *v = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (v == MAP_FAILED) {
+      perror("mmap()");
+      if (!use_stdin) {
+        close(fd);
+      }
+      return false;
+    }
+
+    madvise(v, st.st_size, MADV_SEQUENTIAL);
+    map_ = reinterpret_cast<const char *>(v);
+    map_size_ = st.st_size;
+    p = map_;
+    end = map_ + map_size_;
+  } else {
+    /* pipes and terminals are read by read_stream() */
+    fd_ = fd;
+    separator_ = separator;
+    items_.clear();
+    return true;
+  }
+
+  if (!use_stdin) {
+    close(fd);
+  }
+
+  end = p + strip_final_newline(p, end - p, separator);
+
+  /* a trailing separator ends the last option instead of adding an
+   * empty one */
+  if (end > p && end[-1] == separator) {
+    --end;
+  }
+
+  items_.clear();
+
+  if (end > p) {
+    split(p, end, separator);
+  }
+  return true;
+}
+
+void option_list::add_streamed(const char *p, size_t len, std::vector<str_view> &batch)
+{
+  /* CRLF line endings */
+  if (separator_ == '\n' && len > 0 && p[len - 1] == '\r') {
+    len--;
+  }
+
+  str_view v = { arena_.store(p, len), len };
+  batch.push_back(v);
+}
+
+void option_list::read_stream(void (*notify)())
+{
+  char *buf = new char[READ_SIZE];
+  std::vector<str_view> batch;
+  ssize_t n;
+
+  for ( ; ; ) {
+    n = read(fd_, buf, READ_SIZE);
+
+    if (n == 0) {
+      break;
+    } else if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("read()");
+      break;
+    }
+
+    const char *p = buf;
+    const char *end = buf + n;
+    const char *q;
+
+    while ((q = reinterpret_cast<const char *>(memchr(p, separator_, end - p))) != NULL) {
+      if (partial_.empty()) {
+        add_streamed(p, q - p, batch);
+      } else {
+        /* the option started in an earlier read */
+        partial_.append(p, q - p);
+        add_streamed(partial_.data(), partial_.size(), batch);
+        partial_.clear();
+      }
+      p = q + 1;
+    }
+    partial_.append(p, end - p);
+
+    if (!batch.empty()) {
+      pthread_mutex_lock(&mutex_);
+      pending_.insert(pending_.end(), batch.begin(), batch.end());
+      pthread_mutex_unlock(&mutex_);
+      batch.clear();
+
+      if (notify) {
+        notify();
+      }
+    }
+  }
+
+  partial_.resize(strip_final_newline(partial_.data(), partial_.size(), separator_));
+
+  /* the input doesn't have to end with a separator */
+  if (!partial_.empty()) {
+    add_streamed(partial_.data(), partial_.size(), batch);
+    partial_.clear();
+
+    pthread_mutex_lock(&mutex_);
+    pending_.insert(pending_.end(), batch.begin(), batch.end());
+    pthread_mutex_unlock(&mutex_);
+
+    if (notify) {
+      notify();
+    }
+  }
+
+  if (fd_ != STDIN_FILENO) {
+    close(fd_);
+  }
+  delete[] buf;
+}
+
+size_t option_list::sync()
+{
+  size_t n;
+
+  pthread_mutex_lock(&mutex_);
+  n = pending_.size();
+  items_.insert(items_.end(), pending_.begin(), pending_.end());
+  pending_.clear();
+  pthread_mutex_unlock(&mutex_);
+
+  return n;
+}
@@ -0,0 +1,116 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OPTION_LIST_HPP
+#define OPTION_LIST_HPP
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stddef.h>
+
+
+/* A string that points into a buffer owned by someone else.  It is not
+ * NUL terminated. */
+struct str_view
+{
+  const char *data;
+  size_t len;
+};
+
+
+/* Copies strings into large chunks that are never moved, so the copies
+ * stay valid while more strings are added.  Each copy is followed by a
+ * NUL byte. */
+class text_arena
+{
+public:
+  text_arena();
+  ~text_arena();
+
+  const char *store(const char *p, size_t len);
+
+private:
+  std::vector<char *> chunks_;
+  size_t used_;
+};
+
+
+/* The options of the checklist, radiolist and dropdown dialogs.  The input
+ * is kept in one buffer (a mapping of the file if possible) and split into
+ * views pointing into that buffer in a single pass, so the options are
+ * never copied.
+ *
+ * Input from a pipe is streamed instead: read_stream() reads it on another
+ * thread and the options show up with sync(), so a dialog can be used
+ * while the input is still arriving. */
+class option_list
+{
+public:
+  option_list();
+  ~option_list();
+
+  /* takes over the contents of s */
+  void load_string(std::string &s, char separator);
+
+  /* reads the options from a file or from stdin if file is "-"; the
+   * input may end with a separator; prints an error message and returns
+   * false on failure */
+  bool load_file(const char *file, char separator);
+
+  /* true if load_file() left the input to read_stream() */
+  bool streaming() const { return fd_ != -1; }
+
+  /* Reads the input until it ends, calling notify() (if not NULL) each
+   * time new options were read.  Can be called on any thread. */
+  void read_stream(void (*notify)());
+
+  /* Makes the options that were read so far available.  Call it on the
+   * thread that uses the options; data() may change.  Returns the number
+   * of new options. */
+  size_t sync();
+
+  size_t size() const { return items_.size(); }
+  const str_view &operator[](size_t i) const { return items_[i]; }
+  const str_view *data() const { return items_.empty() ? NULL : &items_[0]; }
+
+private:
+  std::string buffer_;
+  const char *map_;
+  size_t map_size_;
+  std::vector<str_view> items_;
+
+  /* streaming */
+  int fd_;
+  char separator_;
+  text_arena arena_;
+  std::string partial_;
+  std::vector<str_view> pending_;
+  pthread_mutex_t mutex_;
+
+  void split(const char *p, const char *end, char separator);
+  void add_streamed(const char *p, size_t len, std::vector<str_view> &batch);
+};
+
+#endif  /* !OPTION_LIST_HPP */
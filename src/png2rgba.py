@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2020, djcj <djcj@gmx.de>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+# Decode PNG files at build time and print them as a C++ header with
+# constexpr pixel arrays, so the program doesn't need to inflate them at
+# runtime.  Usage: png2rgba.py FILE.png [...] > header.h
+#
+# Every FILE becomes a `static constexpr rgba_data NAME_rgba' (see
+# fltk-dialog.hpp), where NAME is the path without ".png" and with all
+# other characters than [A-Za-z0-9] replaced by `_', like `xxd -i' does.
+#
+# The pixels are stored with straight (not premultiplied) alpha, which is
+# what Fl_RGB_Image expects.  Images without an alpha channel or tRNS
+# chunk keep their depth of 1 (gray) or 3 (RGB) bytes per pixel.
+#
+# Only 8 bit, non-interlaced images are supported.
+
+import re
+import struct
+import sys
+import zlib
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+
+def error(msg):
+    sys.stderr.write('png2rgba.py: %s\n' % msg)
+    sys.exit(1)
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    if pb <= pc:
+        return b
+    return c
+
+
+def unfilter(raw, w, h, bpp):
+    stride = w * bpp
+    out = bytearray(stride * h)
+    prev = bytearray(stride)
+    pos = 0
+
+    for y in range(h):
+        ftype = raw[pos]
+        line = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+
+        if ftype == 1:
+            for x in range(bpp, stride):
+                line[x] = (line[x] + line[x - bpp]) & 0xff
+        elif ftype == 2:
+            for x in range(stride):
+                line[x] = (line[x] + prev[x]) & 0xff
+        elif ftype == 3:
+            for x in range(stride):
+                left = line[x - bpp] if x >= bpp else 0
+                line[x] = (line[x] + ((left + prev[x]) >> 1)) & 0xff
+        elif ftype == 4:
+            for x in range(stride):
+                left = line[x - bpp] if x >= bpp else 0
+                upleft = prev[x - bpp] if x >= bpp else 0
+                line[x] = (line[x] + paeth(left, prev[x], upleft)) & 0xff
+        elif ftype != 0:
+            error('unknown filter type %d' % ftype)
+
+        out[y * stride:(y + 1) * stride] = line
+        prev = line
+
+    return out
+
+
+def decode(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data[:8] != PNG_SIGNATURE:
+        error('%s: not a PNG file' % path)
+
+    pos = 8
+    idat = b''
+    plte = None
+    trns = None
+
+    while pos < len(data):
+        length, ctype = struct.unpack('>I4s', data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+
+        if ctype == b'IHDR':
+            w, h, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+        elif ctype == b'PLTE':
+            plte = chunk
+        elif ctype == b'tRNS':
+            trns = chunk
+        elif ctype == b'IDAT':
+            idat += chunk
+        elif ctype == b'IEND':
+            break
+
+    if depth != 8 or interlace != 0:
+        error('%s: only 8 bit non-interlaced images are supported' % path)
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}.get(color)
+    if channels is None:
+        error('%s: unknown color type %d' % (path, color))
+
+    px = unfilter(zlib.decompress(idat), w, h, channels)
+
+    if color == 3:
+        if plte is None:
+            error('%s: palette missing' % path)
+        alpha = trns if trns else b''
+        d = 4 if trns else 3
+        out = bytearray()
+        for i in px:
+            out += plte[i * 3:i * 3 + 3]
+            if d == 4:
+                out.append(alpha[i] if i < len(alpha) else 255)
+        return w, h, d, out
+
+    if trns and color in (0, 2):
+        key = struct.unpack('>%dH' % channels, trns)
+        out = bytearray()
+        for i in range(0, len(px), channels):
+            p = px[i:i + channels]
+            out += p
+            out.append(0 if tuple(p) == key else 255)
+        return w, h, channels + 1, out
+
+    return w, h, channels, px
+
+
+def main():
+    if len(sys.argv) < 2:
+        error('usage: png2rgba.py FILE.png [...]')
+
+    out = ['/* generated by png2rgba.py; do not edit */\n']
+
+    for path in sys.argv[1:]:
+        name = re.sub('[^A-Za-z0-9]', '_', re.sub(r'\.png$', '', path)) + '_rgba'
+        w, h, d, px = decode(path)
+
+        out.append('static constexpr unsigned char %s_pixels[%d] = {' % (name, len(px)))
+        for i in range(0, len(px), 16):
+            out.append('  ' + ', '.join('0x%02x' % b for b in px[i:i + 16]) + ',')
+        out.append('};')
+        out.append('static constexpr rgba_data %s = { %s_pixels, %d, %d, %d };\n' % (name, name, w, h, d))
+
+    sys.stdout.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -33,19 +33,68 @@
  ./fltk-dialog --progress --multi=3
 */
 
+/*
+sock=$(mktemp -u)
+./build/fltk_dialog/fltk-dialog --progress --listen=$sock &
+sleep 1
+for i in 1 2 3 4; do \
+  (for n in 25 50 75 100; do sleep $i; echo $n; done) | socat - UNIX-CONNECT:$sock & \
+done
+*/
+
+/*
+The shared memory channel is used from C with the "progress_shm.h" header:
+./build/fltk_dialog/fltk-dialog --progress --shm=myjob &
+int fd = shm_open("/myjob", O_RDWR, 0);
+progress_shm_t *p = progress_shm_map(fd);
+p->total = 1000; p->done = 500;
+*/
+
+// gzip -c big.iso > big.iso.gz & ./build/fltk_dialog/fltk-dialog --progress --watch-pid=$! --watch-fd=3
+// cat big.iso | ./build/fltk_dialog/fltk-dialog --progress --pipe --size=$(stat -c %s big.iso) | gzip > big.iso.gz
+
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "fltk-dialog.hpp"
+#include "bench.hpp"
+#include "line_reader.hpp"
+#include "progress_shm.h"
 
 #define DEFAULT_SLIDER_SIZE 0.2
+#define FRAME_INTERVAL      (1.0/60.0)
+#define PID_POLL_INTERVAL   0.5
+#define LABEL_INTERVAL      0.25  /* update rate and ETA 4 times per second */
+#define RATE_SMOOTHING      0.3   /* weight of the newest rate sample */
+#define RELAY_BUFSIZE       (1024*1024)
+
+/* Linux 5.1 and 5.3 */
+#ifndef SYS_pidfd_send_signal
+# define SYS_pidfd_send_signal 424
+#endif
+#ifndef SYS_pidfd_open
+# define SYS_pidfd_open 434
+#endif
 
 class loop_bar : public Fl_Widget
 {
@@ -74,6 +123,7 @@ static Fl_Button        *but_cancel = NULL;
 static Fl_Progress      *bar = NULL, *bar_main = NULL;
 static int ret = 1;
 static pthread_t t1, t2;
+static bool t1_created = false, t2_created = false;
 
 static
 unsigned int percent = 0
@@ -87,6 +137,44 @@ static bool running = true
 ,           hide_cancel = false;
 
 static long pid = -1;
+static int pidfd = -1;
+
+/* --watch-fd */
+struct rate_meter {
+  double last_time;
+  double last_label;
+  uint64_t last_bytes;
+  double rate;  /* bytes per second */
+};
+
+static int watch_fd = -1;
+static rate_meter meter = { 0, 0, 0, 0 };
+
+/* --pipe */
+static bool pipe_mode = false;
+static uint64_t pipe_size = 0;
+static std::atomic<uint64_t> relay_bytes(0);
+static std::atomic<bool> relay_done(false);
+static std::atomic<bool> relay_failed(false);  /* I/O error or less data than --size */
+
+/* --listen */
+#define LISTEN_MAX_EVENTS 32
+
+struct producer {
+  int fd;
+  int percent;  /* -1 until the producer has sent a number */
+  line_reader *reader;
+};
+
+static const char *listen_path = NULL;
+static int listen_fd = -1;
+static bool listen_socket_created = false;
+static std::vector<producer *> producers;
+
+/* --shm */
+static progress_shm_t *shm = NULL;
+static std::string shm_name;
+static uint32_t shm_label_seq = 0;
 
 void loop_bar::draw()
 {
@@ -129,7 +217,7 @@ loop_bar::loop_bar(int X, int Y, int W, int H)
   slider_size(DEFAULT_SLIDER_SIZE);
 }
 
-static bool progress_pthread_create(pthread_t *thread, void *(*start_routine)(void *))
+static bool progress_pthread_create(pthread_t *thread, void *(*start_routine)(void *), bool &created)
 {
   int errsv = pthread_create(thread, 0, start_routine, NULL);
 
@@ -138,21 +226,35 @@ static bool progress_pthread_create(pthread_t *thread, void *(*start_routine)(vo
     perror("pthread_create()");
     return false;
   }
+  created = true;
   return true;
 }
 
 static void close_cb(Fl_Widget *, long p)
 {
-  pthread_cancel(t1);
-  pthread_cancel(t2);
+  if (t1_created) {
+    pthread_cancel(t1);
+  }
+  if (t2_created) {
+    if (pipe_mode && p == 0) {
+      /* OK is only active once the relay is done; never cut it off */
+      pthread_join(t2, NULL);
+      t2_created = false;
+    } else {
+      pthread_cancel(t2);
+    }
+  }
   win->hide();
   ret = p;
 }
 
 static void cancel_cb(Fl_Widget *o)
 {
-  if (pid > getpid()) {
-    kill(pid, 1);
+  if (pidfd != -1) {
+    /* unlike kill() this can never hit a recycled PID */
+    syscall(SYS_pidfd_send_signal, pidfd, SIGHUP, NULL, 0);
+  } else if (pid > 0) {
+    kill(pid, SIGHUP);
   }
   close_cb(o, 1);
 }
@@ -174,6 +276,37 @@ static void progress_finished(void)
   }
 }
 
+static void set_percent(unsigned int value)
+{
+  char buf[16] = {0};
+
+  percent = value;
+  if (percent >= 100) {
+    percent = 100;
+    running = multi > 1;
+    iteration++;
+  }
+  snprintf(buf, sizeof(buf) - 1, "%d%%", percent);
+  bar->value(percent);
+  bar->copy_label(buf);
+
+  /* update the main progress bar too if --multi=n was given */
+  if (multi > 1) {
+    if (percent == 100) {
+      /* reset % for next iteration */
+      percent = 0;
+    }
+    multi_percent = iteration * 100 + percent;
+    if (multi_percent >= multi * 100) {
+      multi_percent = multi * 100;
+      running = false;
+    }
+    snprintf(buf, sizeof(buf) - 1, "%d%%", multi_percent / multi);
+    bar_main->value(multi_percent);
+    bar_main->copy_label(buf);
+  }
+}
+
 static void parse_line(const char *ch)
 {
   if (running) {
@@ -181,35 +314,9 @@ static void parse_line(const char *ch)
       /* "#comment" line found, change the label */
       box->copy_label(ch + 1);
     } else if (!pulsate && ch[0] >= '0' && ch[0] <= '9') {
-      char buf[16] = {0};
-
       /* number found, update the progress bar */
-      percent = atoi(ch);
-      if (percent >= 100) {
-        percent = 100;
-        running = multi > 1;
-        iteration++;
-      }
-      snprintf(buf, sizeof(buf) - 1, "%d%%", percent);
-      bar->value(percent);
-      bar->copy_label(buf);
-
-      /* update the main progress bar too if --multi=n was given */
-      if (multi > 1) {
-        if (percent == 100) {
-          /* reset % for next iteration */
-          percent = 0;
-        }
-        multi_percent = iteration * 100 + percent;
-        if (multi_percent >= multi * 100) {
-          multi_percent = multi * 100;
-          running = false;
-        }
-        snprintf(buf, sizeof(buf) - 1, "%d%%", multi_percent / multi);
-        bar_main->value(multi_percent);
-        bar_main->copy_label(buf);
-      }
-    } else if (pulsate && strcasecmp(ch, "STOP\n") == 0) {
+      set_percent(atoi(ch));
+    } else if (pulsate && strcasecmp(ch, "STOP") == 0) {
       /* stop now */
       running = false;
     }
@@ -226,22 +333,706 @@ static void parse_line(const char *ch)
 
 extern "C" void *progress_getline(void *)
 {
-  char *line = NULL;
-  size_t len = 0;
+  line_reader reader(STDIN_FILENO);
+  std::vector<line_view> lines;
 
-  while (getline(&line, &len, stdin) != -1) {
+  /* lock once per batch of lines instead of once per line */
+  while (reader.next_batch(lines)) {
     Fl::lock();
-    parse_line(line);
+    bench_input(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+      parse_line(lines[i].data);
+    }
     Fl::unlock();
     Fl::awake();
   }
 
-  if (line) {
-    free(line);
+  return nullptr;
+}
+
+/* average over all producers that have sent a number so far */
+static unsigned int merged_percent(void)
+{
+  unsigned int sum = 0, n = 0;
+
+  for (size_t i = 0; i < producers.size(); ++i) {
+    if (producers[i]->percent >= 0) {
+      sum += producers[i]->percent;
+      n++;
+    }
+  }
+  return (n > 0) ? sum / n : 0;
+}
+
+/* must be called with Fl::lock() held */
+static void parse_producer_line(producer *p, const char *ch)
+{
+  if (running && !pulsate && listen_socket_created && ch[0] >= '0' && ch[0] <= '9') {
+    /* each socket connection has its own percentage */
+    p->percent = atoi(ch);
+    if (p->percent > 100) {
+      p->percent = 100;
+    }
+    set_percent(merged_percent());
+
+    if (!running) {
+      progress_finished();
+    }
+    Fl::redraw();
+  } else {
+    parse_line(ch);
+  }
+}
+
+static int open_listen_path(void)
+{
+  struct stat st;
+  struct sockaddr_un addr;
+  int fd;
+
+  if (strlen(listen_path) >= sizeof(addr.sun_path)) {
+    std::cerr << "error: socket path too long: " << listen_path << std::endl;
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, listen_path, sizeof(addr.sun_path) - 1);
+
+  if (stat(listen_path, &st) == 0) {
+    if (S_ISFIFO(st.st_mode)) {
+      /* O_RDWR keeps the FIFO open when the last writer disconnects */
+      if ((fd = open(listen_path, O_RDWR|O_NONBLOCK|O_CLOEXEC)) == -1) {
+        perror("open()");
+      }
+      return fd;
+    } else if (!S_ISSOCK(st.st_mode)) {
+      std::cerr << "error: file is neither a socket nor a FIFO: " << listen_path << std::endl;
+      return -1;
+    }
+
+    /* only remove the socket if nobody is listening on it anymore */
+    if ((fd = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0)) == -1) {
+      perror("socket()");
+      return -1;
+    }
+
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0) {
+      std::cerr << "error: socket already in use: " << listen_path << std::endl;
+      close(fd);
+      return -1;
+    } else if (errno != ECONNREFUSED) {
+      perror("connect()");
+      close(fd);
+      return -1;
+    }
+    close(fd);
+    unlink(listen_path);
+  }
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0)) == -1) {
+    perror("socket()");
+    return -1;
+  }
+
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+    perror("bind()");
+    close(fd);
+    return -1;
+  }
+
+  listen_socket_created = true;
+
+  if (listen(fd, SOMAXCONN) == -1) {
+    perror("listen()");
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static producer *add_producer(int efd, int fd)
+{
+  struct epoll_event ev;
+  producer *p = new producer;
+
+  p->fd = fd;
+  p->percent = -1;
+  p->reader = new line_reader(fd, 4096);
+
+  ev.events = EPOLLIN;
+  ev.data.ptr = p;
+
+  if (epoll_ctl(efd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    perror("epoll_ctl()");
+    close(fd);
+    delete p->reader;
+    delete p;
+    return NULL;
+  }
+
+  Fl::lock();
+  producers.push_back(p);
+  Fl::unlock();
+
+  return p;
+}
+
+extern "C" void *progress_listen(void *)
+{
+  struct epoll_event events[LISTEN_MAX_EVENTS];
+  std::vector<line_view> lines;
+  int lfd = listen_fd, efd, n;
+  bool is_socket = listen_socket_created;
+
+  if ((efd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    perror("epoll_create1()");
+    close(lfd);
+    return nullptr;
+  }
+
+  if (is_socket) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;  /* marks the listening socket */
+
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, lfd, &ev) == -1) {
+      perror("epoll_ctl()");
+      close(efd);
+      close(lfd);
+      return nullptr;
+    }
+  } else if (!add_producer(efd, lfd)) {
+    close(efd);
+    return nullptr;
+  }
+
+  for (;;) {
+    if ((n = epoll_wait(efd, events, LISTEN_MAX_EVENTS, -1)) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("epoll_wait()");
+      break;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      producer *p = reinterpret_cast<producer *>(events[i].data.ptr);
+
+      if (!p) {
+        /* new connections */
+        int cfd;
+        while ((cfd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC)) != -1) {
+          add_producer(efd, cfd);
+        }
+        continue;
+      }
+
+      /* read until the non-blocking descriptor would block */
+      while (p->reader->next_batch(lines)) {
+        Fl::lock();
+        bench_input(lines.size());
+        for (size_t j = 0; j < lines.size(); ++j) {
+          parse_producer_line(p, lines[j].data);
+        }
+        Fl::unlock();
+      }
+
+      if (p->reader->eof()) {
+        /* keep the producer's last percentage in the merged value */
+        epoll_ctl(efd, EPOLL_CTL_DEL, p->fd, NULL);
+        close(p->fd);
+        p->fd = -1;
+        delete p->reader;
+        p->reader = NULL;
+      }
+
+      Fl::awake();
+    }
   }
+
+  close(efd);
+  close(lfd);
+
   return nullptr;
 }
 
+static bool create_shm(const char *name)
+{
+  int fd;
+  void *v;
+
+  if (strcmp(name, "-") == 0) {
+    if ((fd = create_memfd("fltk-dialog-progress", MFD_CLOEXEC)) == -1) {
+      perror("memfd_create()");
+      return false;
+    }
+  } else {
+    shm_name = (name[0] == '/') ? name : std::string("/") + name;
+
+    /* never reset a segment that another dialog is using */
+    if ((fd = shm_open(shm_name.c_str(), O_RDWR|O_CREAT|O_EXCL|O_CLOEXEC, 0600)) == -1) {
+      if (errno == EEXIST) {
+        std::cerr << "error: shared memory object already exists: " << shm_name << std::endl;
+      } else {
+        perror("shm_open()");
+      }
+      shm_name.clear();
+      return false;
+    }
+  }
+
+  if (ftruncate(fd, sizeof(progress_shm_t)) == -1) {
+    perror("ftruncate()");
+    v = MAP_FAILED;
+  } else if ((v = mmap(NULL, sizeof(progress_shm_t), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    perror("mmap()");
+  }
+
+  if (v == MAP_FAILED) {
+    close(fd);
+
+    if (!shm_name.empty()) {
+      shm_unlink(shm_name.c_str());
+      shm_name.clear();
+    }
+    return false;
+  }
+
+  shm = reinterpret_cast<progress_shm_t *>(v);
+  memset(v, 0, sizeof(progress_shm_t));
+  shm->version = PROGRESS_SHM_VERSION;
+  __atomic_store_n(&shm->magic, PROGRESS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+  if (shm_name.empty()) {
+    /* the descriptor must stay open for the path to be valid */
+    std::cout << "/proc/" << getpid() << "/fd/" << fd << std::endl;
+  } else {
+    close(fd);
+  }
+
+  return true;
+}
+
+/* sample the shared memory counters once per frame */
+static void shm_sample_cb(void *)
+{
+  bool changed = false;
+
+  if (running) {
+    uint32_t seq = __atomic_load_n(&shm->label_seq, __ATOMIC_ACQUIRE);
+
+    if (seq != shm_label_seq && (seq & 1) == 0) {
+      char label[PROGRESS_SHM_LABEL_MAX];
+      memcpy(label, shm->label, sizeof(label));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+      if (__atomic_load_n(&shm->label_seq, __ATOMIC_RELAXED) == seq) {
+        label[sizeof(label) - 1] = '\0';
+        box->copy_label(label);
+        shm_label_seq = seq;
+        changed = true;
+      }
+    }
+
+    uint64_t total = __atomic_load_n(&shm->total, __ATOMIC_RELAXED);
+    uint64_t done = __atomic_load_n(&shm->done, __ATOMIC_RELAXED);
+
+    if (!pulsate && total > 0) {
+      unsigned int value = (done >= total) ? 100 : done * 100 / total;
+
+      if (value != percent) {
+        set_percent(value);
+        changed = true;
+      }
+    } else if (pulsate && __atomic_load_n(&shm->finished, __ATOMIC_RELAXED)) {
+      running = false;
+    }
+  }
+
+  if (!running) {
+    progress_finished();
+    Fl::redraw();
+    return;
+  }
+
+  if (changed) {
+    Fl::redraw();
+  }
+  Fl::repeat_timeout(FRAME_INTERVAL, shm_sample_cb);
+}
+
+static double monotonic_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void format_bytes(char *buf, size_t size, double bytes)
+{
+  const char *units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+  int i = 0;
+
+  while (bytes >= 1024 && i < 4) {
+    bytes /= 1024;
+    i++;
+  }
+  snprintf(buf, size, (i == 0) ? "%.0f %s" : "%.1f %s", bytes, units[i]);
+}
+
+/* returns true if the label should be refreshed */
+static bool rate_meter_update(rate_meter &m, uint64_t bytes)
+{
+  double now = monotonic_time();
+
+  if (m.last_time == 0) {
+    m.last_time = m.last_label = now;
+    m.last_bytes = bytes;
+    return true;
+  }
+
+  if (now - m.last_label < LABEL_INTERVAL) {
+    return false;
+  }
+
+  if (bytes >= m.last_bytes) {
+    double r = (bytes - m.last_bytes) / (now - m.last_time);
+    m.rate = (m.rate == 0) ? r : m.rate + RATE_SMOOTHING * (r - m.rate);
+  }
+  m.last_time = m.last_label = now;
+  m.last_bytes = bytes;
+
+  return true;
+}
+
+/* "42% - 3.1 MiB/s - ETA 1:05" or "12.0 MiB - 3.1 MiB/s" if the size is unknown */
+static void set_transfer_label(const rate_meter &m, uint64_t bytes, uint64_t size)
+{
+  char label[128], rate[32];
+
+  format_bytes(rate, sizeof(rate), m.rate);
+
+  if (size > 0) {
+    unsigned int pc = (bytes >= size) ? 100 : bytes * 100 / size;
+
+    if (m.rate > 0 && bytes < size) {
+      unsigned long eta = (size - bytes) / m.rate;
+      if (eta >= 3600) {
+        snprintf(label, sizeof(label), "%u%% - %s/s - ETA %lu:%02lu:%02lu",
+                 pc, rate, eta / 3600, (eta / 60) % 60, eta % 60);
+      } else {
+        snprintf(label, sizeof(label), "%u%% - %s/s - ETA %lu:%02lu", pc, rate, eta / 60, eta % 60);
+      }
+    } else {
+      snprintf(label, sizeof(label), "%u%% - %s/s", pc, rate);
+    }
+  } else {
+    char done[32];
+    format_bytes(done, sizeof(done), bytes);
+    snprintf(label, sizeof(label), "%s - %s/s", done, rate);
+  }
+
+  bar->copy_label(label);
+}
+
+/* read a "key: value" field from a file in /proc */
+static bool read_proc_field(const char *path, const char *key, uint64_t &value)
+{
+  char line[256];
+  size_t len = strlen(key);
+  bool found = false;
+  FILE *fp = fopen(path, "r");
+
+  if (!fp) {
+    return false;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+    if (strncmp(line, key, len) == 0 && line[len] == ':') {
+      value = strtoull(line + len + 1, NULL, 10);
+      found = true;
+      break;
+    }
+  }
+
+  fclose(fp);
+  return found;
+}
+
+/* derive the progress from the watched process' file offset, like `progress' or `pv -d' */
+static void watch_fd_sample_cb(void *)
+{
+  char path[64];
+  struct stat st;
+  uint64_t pos = 0, size = 0, bytes;
+
+  if (pid <= 0 || !running) {
+    return;
+  }
+
+  snprintf(path, sizeof(path), "/proc/%ld/fdinfo/%d", pid, watch_fd);
+
+  if (read_proc_field(path, "pos", pos)) {
+    snprintf(path, sizeof(path), "/proc/%ld/fd/%d", pid, watch_fd);
+
+    if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+      size = st.st_size;
+    }
+  }
+
+  if (size > 0) {
+    bytes = pos;
+  } else {
+    /* not a regular file: show the overall throughput of the process */
+    snprintf(path, sizeof(path), "/proc/%ld/io", pid);
+    if (!read_proc_field(path, "rchar", bytes)) {
+      Fl::repeat_timeout(FRAME_INTERVAL, watch_fd_sample_cb);
+      return;
+    }
+  }
+
+  bool refresh = rate_meter_update(meter, bytes);
+
+  if (size > 0) {
+    unsigned int value = (pos >= size) ? 100 : pos * 100 / size;
+
+    if (value != percent) {
+      /* overwrites the label */
+      set_percent(value);
+      refresh = true;
+    }
+  }
+
+  if (refresh) {
+    set_transfer_label(meter, bytes, size);
+  }
+
+  if (!running) {
+    progress_finished();
+  } else {
+    Fl::repeat_timeout(FRAME_INTERVAL, watch_fd_sample_cb);
+  }
+  Fl::redraw();
+}
+
+static bool write_all(int fd, const char *buf, size_t len)
+{
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buf += n;
+    len -= n;
+    relay_bytes += n;
+  }
+  return true;
+}
+
+/* copy up to len bytes (or until EOF if len is 0) using read()/write() */
+static bool relay_copy(int in, size_t len)
+{
+  char *buf = new char[RELAY_BUFSIZE];
+  bool rv = true;
+
+  for (;;) {
+    size_t count = (len > 0 && len < RELAY_BUFSIZE) ? len : RELAY_BUFSIZE;
+    ssize_t n = read(in, buf, count);
+
+    if (n == 0) {
+      break;
+    } else if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("read()");
+      rv = false;
+      break;
+    }
+
+    if (!write_all(STDOUT_FILENO, buf, n)) {
+      perror("write()");
+      rv = false;
+      break;
+    }
+
+    if (len > 0 && (len -= n) == 0) {
+      break;
+    }
+  }
+
+  delete[] buf;
+  return rv;
+}
+
+/* Relay stdin to stdout with splice() through a pipe, so the data never
+ * has to be copied to user space; fall back to read()/write() if either
+ * side doesn't support splicing (i.e. terminals or files opened with O_APPEND). */
+extern "C" void *progress_relay(void *)
+{
+  int p[2];
+  bool fallback = true;
+
+  if (pipe2(p, O_CLOEXEC) == 0) {
+    fallback = false;
+    fcntl(p[1], F_SETPIPE_SZ, RELAY_BUFSIZE);
+
+    for (;;) {
+      ssize_t n = splice(STDIN_FILENO, NULL, p[1], NULL, RELAY_BUFSIZE, SPLICE_F_MOVE|SPLICE_F_MORE);
+
+      if (n == 0) {
+        break;
+      } else if (n == -1) {
+        if (errno == EINTR) {
+          continue;
+        } else if (errno == EINVAL) {
+          fallback = true;
+        } else {
+          perror("splice()");
+          relay_failed = true;
+        }
+        break;
+      }
+
+      while (n > 0) {
+        ssize_t m = splice(p[0], NULL, STDOUT_FILENO, NULL, n, SPLICE_F_MOVE|SPLICE_F_MORE);
+
+        if (m == -1 && errno == EINTR) {
+          continue;
+        } else if (m == -1 && errno == EINVAL) {
+          /* stdout can't be spliced into: drain the pipe and copy from now on */
+          if (!relay_copy(p[0], n)) {
+            relay_failed = true;
+          } else {
+            fallback = true;
+          }
+          break;
+        } else if (m <= 0) {
+          perror("splice()");
+          relay_failed = true;
+          break;
+        }
+        n -= m;
+        relay_bytes += m;
+      }
+
+      if (n > 0) {
+        break;
+      }
+    }
+
+    close(p[0]);
+    close(p[1]);
+  }
+
+  if (fallback && !relay_failed && !relay_copy(STDIN_FILENO, 0)) {
+    relay_failed = true;
+  }
+
+  /* let the next process in the pipeline see EOF right away */
+  close(STDOUT_FILENO);
+  relay_done = true;
+  Fl::awake();
+
+  return nullptr;
+}
+
+static void relay_sample_cb(void *)
+{
+  uint64_t bytes = relay_bytes;
+  bool done = relay_done;
+  bool refresh = rate_meter_update(meter, bytes);
+
+  if (!running) {
+    return;
+  }
+
+  /* the upstream ended before the announced size */
+  if (done && pipe_size > 0 && bytes < pipe_size) {
+    relay_failed = true;
+  }
+
+  if (pipe_size > 0) {
+    unsigned int value = (bytes >= pipe_size) ? 100 : bytes * 100 / pipe_size;
+
+    /* The estimate may have been too low: stay below 100% until the input
+     * has ended, as reaching 100% would finish the dialog and stop the
+     * relay. */
+    if (done && !relay_failed) {
+      value = 100;
+    } else if (value > 99) {
+      value = 99;
+    }
+
+    if (value != percent) {
+      /* overwrites the label */
+      set_percent(value);
+      refresh = true;
+    }
+  }
+
+  if (done) {
+    running = false;
+  }
+
+  if (refresh || done) {
+    set_transfer_label(meter, bytes, pipe_size);
+  }
+
+  if (!running) {
+    progress_finished();
+  } else {
+    Fl::repeat_timeout(FRAME_INTERVAL, relay_sample_cb);
+  }
+  Fl::redraw();
+}
+
+/* the watched process has stopped */
+static void watched_pid_exited(void)
+{
+  pid = -1;
+  running = false;
+  progress_finished();
+  Fl::redraw();
+}
+
+static void pidfd_cb(int fd, void *)
+{
+  Fl::remove_fd(fd);
+  close(fd);
+  pidfd = -1;
+  watched_pid_exited();
+}
+
+/* fallback for kernels without pidfd_open() */
+static void watch_pid_poll_cb(void *)
+{
+  if (pid > 0 && kill(pid, 0) == -1 && errno == ESRCH) {
+    watched_pid_exited();
+  } else if (pid > 0) {
+    Fl::repeat_timeout(PID_POLL_INTERVAL, watch_pid_poll_cb);
+  }
+}
+
+static void watch_pid(void)
+{
+  if ((pidfd = syscall(SYS_pidfd_open, pid, 0)) != -1) {
+    /* the descriptor becomes readable when the process terminates */
+    Fl::add_fd(pidfd, FL_READ, pidfd_cb);
+  } else if (errno == ENOSYS) {
+    Fl::add_timeout(PID_POLL_INTERVAL, watch_pid_poll_cb);
+  } else {
+    perror("pidfd_open()");
+    pid = -1;
+  }
+}
+
 extern "C" void *pulsate_bar_thread(void *)
 {
   while (running) {
@@ -254,11 +1045,6 @@ extern "C" void *pulsate_bar_thread(void *)
     lp->value(val);
     Fl::redraw();
 
-    if (pid > getpid() && kill(pid, 0) == -1) {
-      running = false;  /* the watched process has stopped */
-      pid = -1;
-    }
-
     Fl::unlock();
     Fl::awake();
 
@@ -274,7 +1060,8 @@ extern "C" void *pulsate_bar_thread(void *)
   return nullptr;
 }
 
-int dialog_progress(bool pulsate_, unsigned int multi_, long pid_, bool autoclose_, bool hide_cancel_)
+int dialog_progress(bool pulsate_, unsigned int multi_, long pid_, int watch_fd_, bool autoclose_, bool hide_cancel_,
+                    const char *listen_, const char *shm_name_, bool pipe_mode_, uint64_t pipe_size_)
 {
   Fl_Group *g;
   Fl_Box *dummy;
@@ -290,9 +1077,13 @@ int dialog_progress(bool pulsate_, unsigned int multi_, long pid_, bool autoclos
 
   pulsate = pulsate_;
   multi = pulsate ? 1 : multi_;
-  pid = pid_;
+  pid = (pid_ > 0 && pid_ != getpid()) ? pid_ : -1;
+  watch_fd = (pid > 0) ? watch_fd_ : -1;
+  pipe_mode = pipe_mode_;
+  pipe_size = pipe_size_;
   autoclose = autoclose_;
   hide_cancel = hide_cancel_;
+  listen_path = listen_;
 
   if (hide_cancel && autoclose) {
     h -= 36;
@@ -302,7 +1093,7 @@ int dialog_progress(bool pulsate_, unsigned int multi_, long pid_, bool autoclos
     offset = 40;
   }
 
-  win = new Fl_Double_Window(320, h + offset, title);
+  win = new bench_window(320, h + offset, title);
   win->callback(cancel_cb);
   {
     g = new Fl_Group(0, 0, 320, h + offset);
@@ -369,18 +1160,56 @@ int dialog_progress(bool pulsate_, unsigned int multi_, long pid_, bool autoclos
 
   Fl::lock();
 
+  /* fail now rather than showing a bar that never moves */
+  if (listen_path && (listen_fd = open_listen_path()) == -1) {
+    if (listen_socket_created) {
+      unlink(listen_path);
+    }
+    return 1;
+  }
+
+  if (shm_name_ && !create_shm(shm_name_)) {
+    return 1;
+  }
+
   /* the pulsating bar must run in its own thread */
-  if (pulsate && !progress_pthread_create(&t1, &pulsate_bar_thread)) {
+  if (pulsate && !progress_pthread_create(&t1, &pulsate_bar_thread, t1_created)) {
     return 1;
   }
 
-  if (!progress_pthread_create(&t2, &progress_getline)) {
+  void *(*reader)(void *) = NULL;
+
+  if (pipe_mode) {
+    /* a closed reader must not kill us */
+    signal(SIGPIPE, SIG_IGN);
+    reader = &progress_relay;
+    Fl::add_timeout(FRAME_INTERVAL, relay_sample_cb);
+  } else if (listen_path) {
+    reader = &progress_listen;
+  } else if (!shm && watch_fd < 0) {
+    /* nothing is read from stdin if the progress comes from shared memory or /proc */
+    reader = &progress_getline;
+  }
+
+  if (reader && !progress_pthread_create(&t2, reader, t2_created)) {
     if (pulsate) {
       pthread_cancel(t1);
     }
     return 1;
   }
 
+  if (shm) {
+    Fl::add_timeout(FRAME_INTERVAL, shm_sample_cb);
+  }
+
+  if (pid > 0) {
+    watch_pid();
+  }
+
+  if (watch_fd >= 0) {
+    Fl::add_timeout(FRAME_INTERVAL, watch_fd_sample_cb);
+  }
+
   set_taskbar(win);
   win->show();
   set_undecorated(win);
@@ -388,6 +1217,19 @@ int dialog_progress(bool pulsate_, unsigned int multi_, long pid_, bool autoclos
 
   Fl::run();
 
+  if (listen_socket_created) {
+    unlink(listen_path);
+  }
+
+  if (!shm_name.empty()) {
+    shm_unlink(shm_name.c_str());
+  }
+
+  /* a broken --pipe transfer must not look like success */
+  if (relay_failed) {
+    return 1;
+  }
+
   return ret;
 }
 
@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PROGRESS_SHM_H
+#define PROGRESS_SHM_H
+
+/* Shared memory progress channel for `fltk-dialog --progress --shm=NAME'.
+ *
+ * The dialog creates and initializes the segment, producers only map it
+ * and update the counters; the dialog samples them once per frame.  With
+ * --shm=- an anonymous memfd is used instead and its path is printed on
+ * stdout.
+ *
+ * Write the counters with relaxed atomic stores: a plain store of a 64 bit
+ * value is split in two on 32 bit targets, and the dialog could see half
+ * of an update.
+ *
+ *   int fd = shm_open("/NAME", O_RDWR, 0);  // or open() the printed path
+ *   progress_shm_t *p = progress_shm_map(fd);
+ *   close(fd);
+ *   __atomic_store_n(&p->total, n, __ATOMIC_RELAXED);
+ *   for (i = 0; i < n; ++i) {
+ *     work(i);
+ *     __atomic_store_n(&p->done, i + 1, __ATOMIC_RELAXED);
+ *   }
+ *   progress_shm_set_label(p, "Done.");
+ *   progress_shm_unmap(p);
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define PROGRESS_SHM_MAGIC      0x47504446  /* "FDPG" */
+#define PROGRESS_SHM_VERSION    1
+#define PROGRESS_SHM_LABEL_MAX  256
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  volatile uint64_t done;
+  volatile uint64_t total;
+  volatile uint32_t finished;   /* set to 1 to stop a pulsating bar */
+  volatile uint32_t label_seq;  /* odd while the label is being written */
+  char label[PROGRESS_SHM_LABEL_MAX];
+} progress_shm_t;
+
+/* returns NULL if fd is not an initialized progress segment */
+static inline progress_shm_t *progress_shm_map(int fd)
+{
+  void *v = mmap(NULL, sizeof(progress_shm_t), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  progress_shm_t *p;
+
+  if (v == MAP_FAILED) {
+    return NULL;
+  }
+  p = (progress_shm_t *)v;
+
+  if (p->magic != PROGRESS_SHM_MAGIC || p->version != PROGRESS_SHM_VERSION) {
+    munmap(v, sizeof(progress_shm_t));
+    return NULL;
+  }
+  return p;
+}
+
+static inline void progress_shm_unmap(progress_shm_t *p)
+{
+  munmap((void *)p, sizeof(progress_shm_t));
+}
+
+/* seqlock write; the reader retries if the sequence changed while copying */
+static inline void progress_shm_set_label(progress_shm_t *p, const char *label)
+{
+  size_t len = strlen(label);
+
+  if (len >= PROGRESS_SHM_LABEL_MAX) {
+    len = PROGRESS_SHM_LABEL_MAX - 1;
+  }
+  __atomic_add_fetch(&p->label_seq, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(p->label, label, len);
+  p->label[len] = '\0';
+  __atomic_add_fetch(&p->label_seq, 1, __ATOMIC_RELEASE);
+}
+
+#endif  /* PROGRESS_SHM_H */
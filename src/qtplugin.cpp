@@ -30,6 +30,8 @@
 #include <QSystemTrayIcon>
 
 #include <iostream>
+#include <vector>
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
@@ -38,6 +40,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "line_reader.hpp"
+
 /**
  Note: I'm getting errors like this:
   $ QObject: Cannot create children for a parent that is in a different thread.
@@ -153,16 +157,16 @@ static void callback(void)
   }
 }
 
-static FILE *open_named_pipe(void)
+static int open_named_pipe(void)
 {
-  FILE *fp = NULL;
+  int fd;
 
   if (access(named_pipe, F_OK) == -1) {
     /* path doesn't exist -> make FIFO */
     if (mkfifo(named_pipe, 0644) == -1) {
       /* cannot make FIFO */
       perror("mkfifo()");
-      return NULL;
+      return -1;
     }
   } else {
     /* path exists -> check if it's a FIFO */
@@ -171,42 +175,47 @@ static FILE *open_named_pipe(void)
 
     if ((st.st_mode & S_IFMT) != S_IFIFO) {
       std::cerr << "error: file is not a FIFO: " << named_pipe << std::endl;
-      return NULL;
+      return -1;
     }
   }
 
-  if ((fp = fopen(named_pipe, "r+")) == NULL) {
-    perror("fopen()");
+  /* O_RDWR keeps the FIFO open when the last writer disconnects */
+  if ((fd = open(named_pipe, O_RDWR|O_CLOEXEC)) == -1) {
+    perror("open()");
   }
 
-  return fp;
+  return fd;
 }
 
 extern "C"
 void *getline_qt(void *)
 {
-  FILE *fp;
-  char *line = NULL;
-  size_t n = 0;
-  ssize_t len;
+  std::vector<line_view> lines;
+  int fd;
 
-  if ((fp = open_named_pipe()) == NULL) {
+  if ((fd = open_named_pipe()) == -1) {
     return nullptr;
   }
 
-  while ((len = getline(&line, &n, fp)) != -1) {
-    if (strcasecmp(line, "QUIT\n") == 0) {
-      appTray->quit();
-      return nullptr;
-    } else if (len > 5 && strncasecmp(line, "ICON:", 5) == 0) {
-      line[len - 1] = '\0';  /* remove trailing newline */
-      set_tray_icon(line + 5);
-    } else if (strcasecmp(line, "RUN\n") == 0) {
-      callback();
+  line_reader reader(fd, 4096);
+
+  while (reader.next_batch(lines)) {
+    for (size_t i = 0; i < lines.size(); ++i) {
+      char *line = lines[i].data;
+
+      if (strcasecmp(line, "QUIT") == 0) {
+        appTray->quit();
+        close(fd);
+        return nullptr;
+      } else if (lines[i].len > 5 && strncasecmp(line, "ICON:", 5) == 0) {
+        set_tray_icon(line + 5);
+      } else if (strcasecmp(line, "RUN") == 0) {
+        callback();
+      }
     }
   }
 
-  fclose(fp);
+  close(fd);
 
   return nullptr;
 }
@@ -24,56 +24,23 @@
 
 #include <iostream>
 #include <string>
-#include <vector>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
 
 #include "fltk-dialog.hpp"
-
-class radiolist_browser : public Fl_Check_Browser
-{
-public:
-  radiolist_browser(int X, int Y, int W, int H) : Fl_Check_Browser(X, Y, W, H) { }
-
-  /* The destructor deletes all list items and destroys the browser. */
-  ~radiolist_browser() { clear(); }
-
-  void item_select(void *v, int) {
-    check_none();
-    reinterpret_cast<cb_item *>(v)->checked = 1;
-    redraw();
-  }
-
-protected:
-  void item_draw(void *v, int X, int Y, int, int) const
-  {
-    /* https://unicode-table.com/en/blocks/geometric-shapes/ */
-    const char *u = "\u25CB";  /* White Circle */
-    const char *c = "\u25C9";  /* Fisheye */
-    //const char *c = "\u25CF";  /* Black Circle */
-
-    cb_item *i = reinterpret_cast<cb_item *>(v);
-    int tsize = textsize();
-    Fl_Color col = active_r() ? textcolor() : fl_inactive(textcolor());
-
-    X += 2;
-    Y += tsize - 1;
-
-    fl_color(active_r() ? FL_FOREGROUND_COLOR : fl_inactive(FL_FOREGROUND_COLOR));
-    fl_font(FL_HELVETICA, tsize);
-    fl_draw(i->checked ? c : u, X, Y - 1);
-
-    fl_font(textfont(), tsize);
-    if (i->selected) {
-      col = fl_contrast(col, selection_color());
-    }
-    fl_color(col);
-    fl_draw(i->text, X + tsize + 4, Y);
-  }
-};
+#include "frame_update.hpp"
+#include "fuzzy_filter.hpp"
+#include "list_view.hpp"
 
 static Fl_Double_Window *win;
 static Fl_Return_Button *but_ok;
-static radiolist_browser *browser;
-static int browser_rv = 0;
+static list_view *browser;
+static fuzzy_filter *filter;
+static Fl_Input *filter_input;
+static option_list *options;
+static bool too_few = false;
+static long browser_rv = 0;
 static bool but_ok_activated = false;
 static int ret = 1;
 
@@ -90,27 +57,83 @@ static void callback(Fl_Widget *) {
   browser_rv = browser->value();
 }
 
-int dialog_radiolist(std::string radiolist_options, bool return_number, char separator)
+static void filter_cb(Fl_Widget *o) {
+  Fl_Input *in = dynamic_cast<Fl_Input *>(o);
+  browser->filter(filter->query(in->value()) ? &filter->result() : NULL);
+}
+
+static void frame_cb()
+{
+  if (options->sync() == 0) {
+    return;
+  }
+
+  browser->grow(options->data(), options->size());
+  filter->append(options->data(), options->size());
+
+  if (filter->query(filter_input->value())) {
+    browser->filter(&filter->result(), true);
+  }
+}
+
+static frame_update frame(frame_cb);
+
+/* new options are shown at most once per frame */
+static void schedule_update()
+{
+  frame.request();
+}
+
+static int too_few_options()
+{
+  title = "error: radiolist";
+  msg = "Two or more options required!";
+  dialog_message(MESSAGE_TYPE_WARNING);
+  return 1;
+}
+
+/* the input has ended */
+static void eof_cb(void *)
+{
+  if (!win->shown()) {
+    return;
+  }
+
+  frame_cb();
+
+  if (options->size() < 2) {
+    too_few = true;
+    close_cb(NULL, 1);
+  }
+}
+
+static void *read_options(void *)
+{
+  options->read_stream(schedule_update);
+  Fl::awake(eof_cb);
+  return NULL;
+}
+
+int dialog_radiolist(option_list &options_, bool return_number)
 {
   Fl_Group *g1, *g1a, *g2;
   Fl_Box *dummy1, *dummy2;
   Fl_Button *but_cancel;
   int range;
 
-  std::vector<std::string> vec;
-  split(radiolist_options, separator, vec);
+  options = &options_;
 
-  if (vec.size() < 2) {
-    title = "error: radiolist";
-    msg = "Two or more options required!";
-    dialog_message(MESSAGE_TYPE_WARNING);
-    return 1;
+  if (!options->streaming() && options->size() < 2) {
+    return too_few_options();
   }
 
   if (!title) {
     title = "Select an option";
   }
 
+  fuzzy_filter ff(options->data(), options->size());
+  filter = &ff;
+
   win = new Fl_Double_Window(420, 356, title);
   win->callback(close_cb, 1);
   {
@@ -118,20 +141,19 @@ int dialog_radiolist(std::string radiolist_options, bool return_number, char sep
     {
       g1a = new Fl_Group(0, 0, 420, 290);
       {
-        for (size_t i = 0; i < vec.size(); ++i)
-        {
-          browser = new radiolist_browser(10, 10, 400, 289);
-          browser->when(FL_WHEN_CHANGED);
-          browser->box(FL_THIN_DOWN_BOX);
-          browser->color(fl_lighter(fl_lighter(FL_BACKGROUND_COLOR)));
-          browser->clear_visible_focus();
-          for (auto it = vec.begin(); it != vec.end(); ++it) {
-            std::string &s = *it;
-            browser->add(s.c_str());
-          }
-          browser->callback(callback);
-          vec.clear();
-        }
+        filter_input = new Fl_Input(10, 10, 400, 26);
+        filter_input->tooltip("Type to filter the list");
+        filter_input->when(FL_WHEN_CHANGED);
+        filter_input->callback(filter_cb);
+
+        /* https://unicode-table.com/en/blocks/geometric-shapes/ */
+        browser = new list_view(10, 42, 400, 247, list_view::RADIO);
+        browser->symbols("\u25CB", "\u25C9");  /* White Circle, Fisheye */
+        browser->box(FL_THIN_DOWN_BOX);
+        browser->color(fl_lighter(fl_lighter(FL_BACKGROUND_COLOR)));
+        browser->clear_visible_focus();
+        browser->items(options->data(), options->size());
+        browser->callback(callback);
         dummy1 = new Fl_Box(10, 288, 400, 1);
         dummy1->box(FL_NO_BOX);
       }
@@ -157,14 +179,36 @@ int dialog_radiolist(std::string radiolist_options, bool return_number, char sep
     g2->resizable(dummy2);
     g2->end();
   }
+
+  /* options from a pipe are added while the dialog is shown */
+  if (options->streaming()) {
+    pthread_t th;
+
+    Fl::lock();
+
+    int errsv = pthread_create(&th, 0, &read_options, NULL);
+
+    if (errsv != 0) {
+      errno = errsv;
+      perror("pthread_create()");
+      return 1;
+    }
+    pthread_detach(th);
+  }
+
   run_window(win, g1, range, 100);
 
+  if (too_few) {
+    return too_few_options();
+  }
+
   if (ret == 0) {
     std::cout << quote;
     if (return_number) {
-      std::cout << browser_rv;
+      /* item numbers start at 1 */
+      std::cout << browser_rv + 1;
     } else {
-      std::cout << browser->text(browser_rv);
+      std::cout.write(browser->text(browser_rv).data, browser->text(browser_rv).len);
     }
     std::cout << quote << std::endl;
   }
@@ -0,0 +1,1343 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "fltk-dialog.hpp"
+#include "line_reader.hpp"
+#include "text_view.hpp"
+
+#define CHUNK_SIZE    (1024*1024)
+#define INDEX_STEP    256
+#define INDEX_BLOCK   (4*1024*1024)
+#define SEARCH_BATCH  65536
+#define TAB_WIDTH     8
+#define WHEEL_LINES   3
+#define HSCROLL_STEP  20
+#define MEASURE_STEP  256
+
+
+text_store::text_store()
+ : first_(0),
+   partial_(0),
+   longest_(0),
+   bytes_(0),
+   max_lines_(0),
+   max_bytes_(0),
+   runs_first_(0),
+   line_run_(0),
+   style_(0),
+   esc_state_(ESC_NONE)
+{
+  spare_.data = NULL;
+  spare_.size = spare_.used = 0;
+  current_.fg = current_.bg = 0;
+  current_.flags = 0;
+  styles_.push_back(current_);
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+text_store::~text_store()
+{
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    free(chunks_[i].data);
+  }
+  free(spare_.data);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void text_store::limit(size_t max_lines, size_t max_bytes)
+{
+  lock();
+  max_lines_ = max_lines;
+  max_bytes_ = max_bytes;
+  trim();
+  unlock();
+}
+
+/* start a new chunk and move the unterminated line over to it,
+ * so that a line is never split across two chunks */
+void text_store::add_chunk(size_t min_size)
+{
+  chunk c;
+
+  if (spare_.data && spare_.size >= min_size) {
+    /* reuse the last released chunk */
+    c = spare_;
+    spare_.data = NULL;
+  } else {
+    c.size = (min_size > CHUNK_SIZE) ? min_size : CHUNK_SIZE;
+    c.data = reinterpret_cast<char *>(malloc(c.size));
+  }
+  c.used = 0;
+
+  if (!c.data) {
+    perror("malloc()");
+    abort();
+  }
+
+  if (partial_ > 0) {
+    chunk &prev = chunks_.back();
+    prev.used -= partial_;
+    memcpy(c.data, prev.data + prev.used, partial_);
+    c.used = partial_;
+  }
+
+  chunks_.push_back(c);
+}
+
+void text_store::add_line(const char *ptr, size_t len)
+{
+  line_ref l;
+  l.ptr = ptr;
+  l.len = (len > UINT32_MAX) ? UINT32_MAX : len;
+  l.run = line_run_;
+  lines_.push_back(l);
+  bytes_ += len + 1;
+
+  if (len > longest_) {
+    longest_ = len;
+  }
+
+  /* the next line continues in the current style */
+  line_run_ = runs_first_ + runs_.size();
+
+  if (style_ != 0) {
+    style_run r = { 0, style_ };
+    runs_.push_back(r);
+  }
+}
+
+/* add text without escape sequences */
+void text_store::add_text(const char *data, size_t len)
+{
+  while (len > 0) {
+    if (chunks_.empty() || chunks_.back().used == chunks_.back().size) {
+      /* grow geometrically for lines that don't fit into a chunk */
+      add_chunk(partial_ * 2);
+      continue;
+    }
+
+    chunk &c = chunks_.back();
+    size_t n = c.size - c.used;
+
+    if (n > len) {
+      n = len;
+    }
+
+    char *dst = c.data + c.used;
+    char *end = dst + n;
+    const char *start = dst - partial_;
+    const char *nl;
+
+    memcpy(dst, data, n);
+    newline_scanner scanner(dst, end);
+
+    while ((nl = scanner.next()) != NULL) {
+      add_line(start, nl - start);
+      start = nl + 1;
+    }
+
+    partial_ = end - start;
+    c.used += n;
+    data += n;
+    len -= n;
+  }
+}
+
+/* Continue parsing an escape sequence, which may have started in an
+ * earlier block of input.  Returns the number of bytes consumed.
+ * SGR sequences change the current style, everything else is dropped. */
+size_t text_store::parse_escape(const char *p, size_t len)
+{
+  size_t i = 0;
+
+  while (i < len && esc_state_ != ESC_NONE) {
+    unsigned char c = p[i];
+
+    switch (esc_state_) {
+      case ESC_START:
+        if (c == '[') {
+          esc_state_ = ESC_CSI;
+        } else if (c == ']') {
+          esc_state_ = ESC_OSC;
+        } else if (c < 0x20 || c > 0x7e) {
+          /* a lone ESC; keep c */
+          esc_state_ = ESC_NONE;
+          continue;
+        } else {
+          /* two-character sequence */
+          esc_state_ = ESC_NONE;
+        }
+        break;
+
+      case ESC_CSI:
+        if (c >= 0x40 && c <= 0x7e) {
+          /* final byte */
+          if (c == 'm') {
+            set_sgr(esc_);
+          }
+          esc_state_ = ESC_NONE;
+        } else if (c >= 0x20 && c <= 0x3f) {
+          if (esc_.size() < 64) {
+            esc_.push_back(c);
+          }
+        } else {
+          /* malformed; keep c */
+          esc_state_ = ESC_NONE;
+          continue;
+        }
+        break;
+
+      case ESC_OSC:
+        /* terminated by BEL or ESC \ */
+        if (c == 0x07) {
+          esc_state_ = ESC_NONE;
+        } else if (c == 0x1b) {
+          esc_state_ = ESC_OSC_ESC;
+        } else if (c == '\n') {
+          esc_state_ = ESC_NONE;
+          continue;
+        }
+        break;
+
+      case ESC_OSC_ESC:
+        esc_state_ = ESC_NONE;
+        break;
+    }
+
+    i++;
+  }
+
+  return i;
+}
+
+static Fl_Color ansi_color(int n)
+{
+  static const unsigned char basic[16][3] = {
+    {   0,   0,   0 }, { 205,   0,   0 }, {   0, 205,   0 }, { 205, 205,   0 },
+    {   0,   0, 238 }, { 205,   0, 205 }, {   0, 205, 205 }, { 229, 229, 229 },
+    { 127, 127, 127 }, { 255,   0,   0 }, {   0, 255,   0 }, { 255, 255,   0 },
+    {  92,  92, 255 }, { 255,   0, 255 }, {   0, 255, 255 }, { 255, 255, 255 }
+  };
+  static const unsigned char cube[6] = { 0, 95, 135, 175, 215, 255 };
+
+  if (n < 0 || n > 255) {
+    return FL_FOREGROUND_COLOR;
+  } else if (n < 16) {
+    return fl_rgb_color(basic[n][0], basic[n][1], basic[n][2]);
+  } else if (n < 232) {
+    n -= 16;
+    return fl_rgb_color(cube[n / 36], cube[(n / 6) % 6], cube[n % 6]);
+  }
+
+  uchar gray = 8 + (n - 232) * 10;
+  return fl_rgb_color(gray);
+}
+
+void text_store::set_sgr(const std::string &params)
+{
+  std::vector<int> v;
+  const char *p = params.c_str();
+
+  /* private sequences */
+  if (*p >= '<' && *p <= '?') {
+    return;
+  }
+
+  /* an empty parameter means 0 */
+  for (;;) {
+    v.push_back(atoi(p));
+    p += strcspn(p, ";:");
+    if (*p == '\0') {
+      break;
+    }
+    p++;
+  }
+
+  for (size_t i = 0; i < v.size(); ++i) {
+    int n = v[i];
+
+    if (n == 0) {
+      current_.fg = current_.bg = 0;
+      current_.flags = 0;
+    } else if (n == 1) {
+      current_.flags |= text_style::BOLD;
+    } else if (n == 22) {
+      current_.flags &= ~text_style::BOLD;
+    } else if (n == 4) {
+      current_.flags |= text_style::UNDERLINE;
+    } else if (n == 24) {
+      current_.flags &= ~text_style::UNDERLINE;
+    } else if (n == 7) {
+      current_.flags |= text_style::INVERSE;
+    } else if (n == 27) {
+      current_.flags &= ~text_style::INVERSE;
+    } else if ((n >= 30 && n <= 37) || (n >= 90 && n <= 97)) {
+      current_.fg = ansi_color((n >= 90) ? n - 90 + 8 : n - 30);
+      current_.flags |= text_style::FG;
+    } else if (n == 39) {
+      current_.fg = 0;
+      current_.flags &= ~text_style::FG;
+    } else if ((n >= 40 && n <= 47) || (n >= 100 && n <= 107)) {
+      current_.bg = ansi_color((n >= 100) ? n - 100 + 8 : n - 40);
+      current_.flags |= text_style::BG;
+    } else if (n == 49) {
+      current_.bg = 0;
+      current_.flags &= ~text_style::BG;
+    } else if ((n == 38 || n == 48) && i + 1 < v.size()) {
+      /* 256 colors or 24 bit colors */
+      Fl_Color c;
+
+      if (v[i + 1] == 5 && i + 2 < v.size()) {
+        c = ansi_color(v[i + 2]);
+        i += 2;
+      } else if (v[i + 1] == 2 && i + 4 < v.size()) {
+        c = fl_rgb_color(v[i + 2], v[i + 3], v[i + 4]);
+        i += 4;
+      } else {
+        break;
+      }
+
+      if (n == 38) {
+        current_.fg = c;
+        current_.flags |= text_style::FG;
+      } else {
+        current_.bg = c;
+        current_.flags |= text_style::BG;
+      }
+    }
+  }
+
+  set_style();
+}
+
+/* look up or add the style number of current_ and start a new run */
+void text_store::set_style()
+{
+  style_key key(static_cast<uint64_t>(current_.fg) << 32 | current_.bg, current_.flags);
+  std::map<style_key, uint16_t>::iterator it = style_ids_.find(key);
+  uint16_t id;
+
+  if (it != style_ids_.end()) {
+    id = it->second;
+  } else if (current_.flags == 0) {
+    id = 0;
+  } else if (styles_.size() <= UINT16_MAX) {
+    id = styles_.size();
+    styles_.push_back(current_);
+    style_ids_[key] = id;
+  } else {
+    /* too many styles */
+    id = 0;
+  }
+
+  if (id == style_) {
+    return;
+  }
+  style_ = id;
+
+  style_run r = { static_cast<uint32_t>(partial_), id };
+
+  if (static_cast<uint32_t>(runs_first_ + runs_.size()) != line_run_ && runs_.back().offset == r.offset) {
+    /* nothing was written with the previous style */
+    runs_.back().style = id;
+  } else {
+    runs_.push_back(r);
+  }
+}
+
+void text_store::append(const char *data, size_t len)
+{
+  lock();
+
+  while (len > 0) {
+    if (esc_state_ != ESC_NONE) {
+      size_t n = parse_escape(data, len);
+      data += n;
+      len -= n;
+      continue;
+    }
+
+    const char *esc = reinterpret_cast<const char *>(memchr(data, 0x1b, len));
+    size_t n = esc ? esc - data : len;
+
+    add_text(data, n);
+    data += n;
+    len -= n;
+
+    if (esc) {
+      esc_state_ = ESC_START;
+      esc_.clear();
+      data++;
+      len--;
+    }
+  }
+
+  trim();
+  unlock();
+}
+
+void text_store::trim()
+{
+  while (!lines_.empty() &&
+         ((max_lines_ > 0 && lines_.size() > max_lines_) ||
+          (max_bytes_ > 0 && bytes_ > max_bytes_)))
+  {
+    bytes_ -= lines_.front().len + 1;
+    lines_.pop_front();
+    first_++;
+  }
+
+  uint32_t run = lines_.empty() ? line_run_ : lines_.front().run;
+
+  while (runs_first_ != run) {
+    runs_.pop_front();
+    runs_first_++;
+  }
+
+  /* the last chunk is never released, it may hold the unterminated line */
+  while (chunks_.size() > 1) {
+    chunk &c = chunks_.front();
+
+    if (!lines_.empty() && lines_.front().ptr >= c.data && lines_.front().ptr < c.data + c.size) {
+      break;
+    }
+
+    if (!spare_.data && c.size == CHUNK_SIZE) {
+      spare_ = c;
+    } else {
+      free(c.data);
+    }
+    chunks_.pop_front();
+  }
+}
+
+void text_store::finish()
+{
+  lock();
+
+  if (partial_ > 0) {
+    chunk &c = chunks_.back();
+    add_line(c.data + c.used - partial_, partial_);
+    partial_ = 0;
+    trim();
+  }
+
+  unlock();
+}
+
+const char *text_store::line(size_t n, size_t &len) const
+{
+  const line_ref &l = lines_[n - first_];
+  len = l.len;
+  return l.ptr;
+}
+
+void text_store::line_runs(size_t n, std::vector<style_run> &runs) const
+{
+  size_t i = n - first_;
+  uint32_t end = (i + 1 < lines_.size()) ? lines_[i + 1].run : line_run_;
+
+  for (uint32_t r = lines_[i].run; r != end; ++r) {
+    runs.push_back(runs_[static_cast<uint32_t>(r - runs_first_)]);
+  }
+}
+
+
+/* the mapping guarded by sigbus_handler() */
+static const char * volatile guard_start = NULL;
+static volatile size_t guard_size = 0;
+static volatile sig_atomic_t truncated = 0;
+
+static void sigbus_handler(int, siginfo_t *si, void *)
+{
+  const char *addr = reinterpret_cast<const char *>(si->si_addr);
+  const char *start = guard_start;
+  size_t size = guard_size;
+
+  if (start && addr >= start && addr < start + size) {
+    size_t pagesize = sysconf(_SC_PAGESIZE);
+    char *page = const_cast<char *>(start) + ((addr - start) & ~(pagesize - 1));
+
+    /* the faulting access is repeated on the zero pages */
+    if (mmap(page, start + size - page, PROT_READ, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED, -1, 0) != MAP_FAILED) {
+      truncated = 1;
+      return;
+    }
+  }
+
+  /* not ours: fault again with the default action */
+  signal(SIGBUS, SIG_DFL);
+}
+
+mapped_text::mapped_text()
+ : data_(NULL),
+   size_(0),
+   fd_(-1),
+   lines_(0),
+   longest_(0),
+   cache_line_(0),
+   cache_off_(0)
+{
+  pthread_mutex_init(&mutex_, NULL);
+  index_.push_back(0);
+}
+
+mapped_text::~mapped_text()
+{
+  if (data_) {
+    guard_start = NULL;
+    munmap(const_cast<char *>(data_), size_);
+  }
+  if (fd_ != -1) {
+    close(fd_);
+  }
+  pthread_mutex_destroy(&mutex_);
+}
+
+bool mapped_text::open(const char *file)
+{
+  struct stat st;
+  int fd = ::open(file, O_RDONLY|O_CLOEXEC);
+
+  if (fd == -1) {
+    perror("open()");
+    return false;
+  }
+
+  if (fstat(fd, &st) == -1) {
+    perror("fstat()");
+    close(fd);
+    return false;
+  }
+
+  if (!S_ISREG(st.st_mode)) {
+    std::cerr << "error: not a regular file: " << file << std::endl;
+    close(fd);
+    return false;
+  }
+
+  /* mmap() fails on empty files */
+  if (st.st_size > 0) {
+    void *v = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (v == MAP_FAILED) {
+      perror("mmap()");
+      close(fd);
+      return false;
+    }
+
+    data_ = reinterpret_cast<const char *>(v);
+    size_ = st.st_size;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = sigbus_handler;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+
+    guard_size = size_;
+    guard_start = data_;
+    sigaction(SIGBUS, &sa, NULL);
+  }
+
+  /* kept open to notice truncation */
+  fd_ = fd;
+  return true;
+}
+
+size_t mapped_text::check_size()
+{
+  struct stat st;
+
+  if (fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) < size_) {
+    return st.st_size;
+  }
+  return size_;
+}
+
+void mapped_text::index(void (*cb)())
+{
+  const char *p = data_;
+  const char *end = data_ + size_;
+  const char *start = p;
+  size_t lines = 0, longest = 0;
+  size_t dropped = 0;
+  size_t pagesize = sysconf(_SC_PAGESIZE);
+  std::vector<size_t> pending;
+
+  while (p < end) {
+    const char *block_end = (static_cast<size_t>(end - p) > INDEX_BLOCK) ? p + INDEX_BLOCK : end;
+    const char *nl;
+    newline_scanner scanner(p, block_end);
+
+    while ((nl = scanner.next()) != NULL) {
+      if (static_cast<size_t>(nl - start) > longest) {
+        longest = nl - start;
+      }
+      start = nl + 1;
+
+      if (++lines % INDEX_STEP == 0) {
+        pending.push_back(start - data_);
+      }
+    }
+
+    p = block_end;
+
+    /* Stop at the new end of a truncated file.  The lines scanned so far
+     * may already reach into the zero pages, but no further. */
+    if (truncated) {
+      size_t size = check_size();
+
+      if (data_ + size < end) {
+        std::cerr << "warning: the file was truncated while it was read" << std::endl;
+        end = (data_ + size > p) ? data_ + size : p;
+        truncated = 0;
+      }
+    }
+
+    /* an unterminated last line */
+    if (p == end && start < end) {
+      if (static_cast<size_t>(end - start) > longest) {
+        longest = end - start;
+      }
+      lines++;
+    }
+
+    lock();
+    index_.insert(index_.end(), pending.begin(), pending.end());
+    lines_ = lines;
+    longest_ = longest;
+    unlock();
+
+    pending.clear();
+    cb();
+
+    /* drop the scanned pages from our address space; they stay in the
+     * page cache and are faulted back in when they're displayed */
+    size_t off = (start - data_) & ~(pagesize - 1);
+    if (off > dropped) {
+      madvise(const_cast<char *>(data_) + dropped, off - dropped, MADV_DONTNEED);
+      dropped = off;
+    }
+  }
+}
+
+const char *mapped_text::line(size_t n, size_t &len) const
+{
+  size_t l, off;
+
+  if (n >= cache_line_ && n - cache_line_ < INDEX_STEP) {
+    l = cache_line_;
+    off = cache_off_;
+  } else {
+    l = n - (n % INDEX_STEP);
+    off = index_[n / INDEX_STEP];
+  }
+
+  for ( ; l < n; ++l) {
+    const char *nl = reinterpret_cast<const char *>(memchr(data_ + off, '\n', size_ - off));
+    off = nl - data_ + 1;
+  }
+
+  cache_line_ = n;
+  cache_off_ = off;
+
+  const char *nl = reinterpret_cast<const char *>(memchr(data_ + off, '\n', size_ - off));
+  len = nl ? nl - (data_ + off) : size_ - off;
+
+  return data_ + off;
+}
+
+
+text_search::text_search(text_source *source, void (*notify)())
+ : source_(source),
+   notify_(notify),
+   generation_(0),
+   pending_(false)
+{
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+}
+
+void *text_search::worker(void *v)
+{
+  reinterpret_cast<text_search *>(v)->run();
+  return nullptr;
+}
+
+bool text_search::start()
+{
+  int errsv = pthread_create(&thread_, 0, worker, this);
+
+  if (errsv != 0) {
+    errno = errsv;
+    perror("pthread_create()");
+    return false;
+  }
+
+  pthread_detach(thread_);
+  return true;
+}
+
+void text_search::query(const std::string &s)
+{
+  pthread_mutex_lock(&mutex_);
+  query_ = s;
+  hits_.clear();
+  generation_++;
+  pending_ = true;
+  pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+void text_search::wakeup()
+{
+  pthread_mutex_lock(&mutex_);
+  pending_ = true;
+  pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+size_t text_search::count()
+{
+  pthread_mutex_lock(&mutex_);
+  size_t n = hits_.size();
+  pthread_mutex_unlock(&mutex_);
+  return n;
+}
+
+bool text_search::next(size_t from, size_t &n)
+{
+  bool rv = false;
+
+  pthread_mutex_lock(&mutex_);
+
+  if (!hits_.empty()) {
+    std::deque<size_t>::iterator it = std::upper_bound(hits_.begin(), hits_.end(), from);
+    n = (it == hits_.end()) ? hits_.front() : *it;
+    rv = true;
+  }
+
+  pthread_mutex_unlock(&mutex_);
+  return rv;
+}
+
+bool text_search::prev(size_t from, size_t &n)
+{
+  bool rv = false;
+
+  pthread_mutex_lock(&mutex_);
+
+  if (!hits_.empty()) {
+    std::deque<size_t>::iterator it = std::lower_bound(hits_.begin(), hits_.end(), from);
+    n = (it == hits_.begin()) ? hits_.back() : *(it - 1);
+    rv = true;
+  }
+
+  pthread_mutex_unlock(&mutex_);
+  return rv;
+}
+
+/* must be called with the source locked */
+void text_search::scan(const std::string &q, size_t from, size_t to, std::vector<size_t> &found)
+{
+  std::vector<const char *> starts;
+  size_t n = from;
+
+  while (n < to) {
+    size_t len;
+    const char *p = source_->line(n, len);
+    const char *end = p + len;
+
+    /* extend the range over all following lines stored right behind it */
+    starts.clear();
+    starts.push_back(p);
+
+    while (n + starts.size() < to) {
+      const char *next = source_->line(n + starts.size(), len);
+      if (next != end + 1) {
+        break;
+      }
+      starts.push_back(next);
+      end = next + len;
+    }
+
+    /* the query has no newline, so a hit never spans two lines */
+    const char *m = p;
+
+    while ((m = reinterpret_cast<const char *>(memmem(m, end - m, q.data(), q.size()))) != NULL) {
+      size_t i = std::upper_bound(starts.begin(), starts.end(), m) - starts.begin() - 1;
+      found.push_back(n + i);
+
+      if (i + 1 == starts.size()) {
+        break;
+      }
+      m = starts[i + 1];
+    }
+
+    n += starts.size();
+  }
+}
+
+void text_search::run()
+{
+  std::string q;
+  std::vector<size_t> found;
+  unsigned int generation = 0;
+  size_t scanned = 0;
+
+  for (;;) {
+    pthread_mutex_lock(&mutex_);
+
+    while (generation == generation_ && !pending_) {
+      pthread_cond_wait(&cond_, &mutex_);
+    }
+
+    if (generation != generation_) {
+      generation = generation_;
+      q = query_;
+      scanned = 0;
+    }
+
+    pending_ = false;
+    pthread_mutex_unlock(&mutex_);
+
+    if (q.empty()) {
+      continue;
+    }
+
+    /* search in batches so the source isn't locked for too long */
+    for (bool done = false; !done; ) {
+      found.clear();
+
+      source_->lock();
+      size_t first = source_->first();
+      size_t end = source_->end();
+
+      if (scanned < first) {
+        scanned = first;
+      }
+
+      size_t to = (end - scanned > SEARCH_BATCH) ? scanned + SEARCH_BATCH : end;
+      scan(q, scanned, to, found);
+      source_->unlock();
+
+      scanned = to;
+      done = (to == end);
+
+      pthread_mutex_lock(&mutex_);
+
+      if (generation != generation_) {
+        /* a new query was entered */
+        pthread_mutex_unlock(&mutex_);
+        break;
+      }
+
+      /* forget lines that were dropped from the source */
+      while (!hits_.empty() && hits_.front() < first) {
+        hits_.pop_front();
+      }
+      hits_.insert(hits_.end(), found.begin(), found.end());
+
+      pthread_mutex_unlock(&mutex_);
+
+      if (!found.empty()) {
+        notify_();
+      }
+    }
+  }
+}
+
+
+text_view::text_view(int X, int Y, int W, int H, text_source *source)
+ : Fl_Group(X, Y, W, H),
+   source_(source),
+   textfont_(FL_HELVETICA),
+   textsize_(FL_NORMAL_SIZE),
+   top_(0),
+   first_(0),
+   end_(0),
+   longest_(0),
+   marked_(static_cast<size_t>(-1)),
+   hpos_(0),
+   autoscroll_(false)
+{
+  box(FL_DOWN_BOX);
+  color(FL_BACKGROUND2_COLOR);
+
+  vscroll_ = new Fl_Scrollbar(0, 0, 0, 0);
+  vscroll_->callback(vscroll_cb, this);
+  vscroll_->clear_visible_focus();
+
+  hscroll_ = new Fl_Scrollbar(0, 0, 0, 0);
+  hscroll_->type(FL_HORIZONTAL);
+  hscroll_->callback(hscroll_cb, this);
+  hscroll_->clear_visible_focus();
+  hscroll_->hide();
+
+  end();
+  resize(X, Y, W, H);
+}
+
+int text_view::line_height() const
+{
+  fl_font(textfont_, textsize_);
+  return fl_height();
+}
+
+int text_view::text_w() const {
+  return w() - Fl::box_dw(box()) - Fl::scrollbar_size();
+}
+
+int text_view::text_h() const {
+  return h() - Fl::box_dh(box()) - (hscroll_->visible() ? Fl::scrollbar_size() : 0);
+}
+
+int text_view::visible_lines() const
+{
+  int n = text_h() / line_height();
+  return (n > 0) ? n : 1;
+}
+
+void text_view::resize(int X, int Y, int W, int H)
+{
+  int sb = Fl::scrollbar_size();
+  int dx = Fl::box_dx(box());
+  int dy = Fl::box_dy(box());
+
+  Fl_Widget::resize(X, Y, W, H);
+
+  vscroll_->resize(X + W - Fl::box_dw(box()) + dx - sb, Y + dy, sb, text_h());
+  hscroll_->resize(X + dx, Y + H - Fl::box_dh(box()) + dy - sb, text_w(), sb);
+
+  scroll_to(top_);
+}
+
+void text_view::update_scrollbars()
+{
+  size_t total = end_ - first_;
+  int vis = visible_lines();
+
+  vscroll_->value(static_cast<int>(top_ - first_), vis, 0, static_cast<int>(total));
+  vscroll_->linesize(1);
+
+  /* good enough for proportional fonts */
+  fl_font(textfont_, textsize_);
+  int max_w = static_cast<int>(longest_ * fl_width('n')) + 4;
+
+  if ((max_w > text_w()) != (hscroll_->visible() != 0)) {
+    if (hscroll_->visible()) {
+      hscroll_->hide();
+    } else {
+      hscroll_->show();
+    }
+    /* move the scrollbars */
+    resize(x(), y(), w(), h());
+    return;
+  }
+
+  if (hscroll_->visible()) {
+    if (hpos_ > max_w - text_w()) {
+      hpos_ = max_w - text_w();
+    }
+    hscroll_->value(hpos_, text_w(), 0, max_w);
+    hscroll_->linesize(HSCROLL_STEP);
+  } else {
+    hpos_ = 0;
+  }
+}
+
+void text_view::scroll_to(size_t top)
+{
+  size_t vis = visible_lines();
+  size_t max = (end_ - first_ > vis) ? end_ - vis : first_;
+
+  if (top < first_) {
+    top = first_;
+  } else if (top > max) {
+    top = max;
+  }
+
+  top_ = top;
+  update_scrollbars();
+  redraw();
+}
+
+void text_view::sync()
+{
+  source_->lock();
+  size_t first = source_->first();
+  size_t end = source_->end();
+  size_t longest = source_->longest();
+  source_->unlock();
+
+  if (first == first_ && end == end_ && longest == longest_) {
+    return;
+  }
+
+  first_ = first;
+  end_ = end;
+  longest_ = longest;
+
+  scroll_to(autoscroll_ ? end_ : top_);
+}
+
+void text_view::vscroll_cb(Fl_Widget *, void *v)
+{
+  text_view *o = reinterpret_cast<text_view *>(v);
+  o->top_ = o->first_ + o->vscroll_->value();
+  o->redraw();
+}
+
+void text_view::hscroll_cb(Fl_Widget *, void *v)
+{
+  text_view *o = reinterpret_cast<text_view *>(v);
+  o->hpos_ = o->hscroll_->value();
+  o->redraw();
+}
+
+void text_view::highlight(const std::string &s)
+{
+  highlight_ = s;
+  redraw();
+}
+
+void text_view::show_line(size_t n)
+{
+  size_t vis = visible_lines();
+
+  marked_ = n;
+
+  if (n < top_ || n >= top_ + vis) {
+    scroll_to(n > vis / 2 ? n - vis / 2 : 0);
+  } else {
+    redraw();
+  }
+}
+
+size_t text_view::current_line() const
+{
+  return (marked_ >= top_ && marked_ < top_ + visible_lines()) ? marked_ : top_;
+}
+
+Fl_Font text_view::style_font(const text_style &st) const
+{
+  return (st.flags & text_style::BOLD) ? (textfont_ | FL_BOLD) : textfont_;
+}
+
+/* x position of the character at offset; needs segments_ */
+int text_view::x_at(const char *text, size_t offset) const
+{
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const segment &seg = segments_[i];
+
+    if (offset <= seg.end) {
+      fl_font(style_font(source_->style(seg.style)), textsize_);
+      return seg.x + static_cast<int>(fl_width(text + seg.begin, static_cast<int>(offset - seg.begin)));
+    }
+  }
+
+  return segments_.back().x + segments_.back().w;
+}
+
+void text_view::draw_line(size_t n, int X, int Y, int H)
+{
+  static std::string buf;
+  size_t len;
+  const char *text = source_->line(n, len);
+
+  runs_.clear();
+  source_->line_runs(n, runs_);
+
+  if (len > 0 && text[len - 1] == '\r') {
+    len--;
+  }
+
+  /* Only lay out the visible part of long lines.  The text is measured in
+   * steps ending on a character boundary until it reaches past the right
+   * edge; expanded tabs and bold text only make it wider. */
+  if (len > MEASURE_STEP) {
+    int limit = hpos_ + text_w();
+    size_t end = 0;
+    double w = 0;
+
+    fl_font(textfont_, textsize_);
+
+    while (end < len && w <= limit) {
+      size_t next = end + MEASURE_STEP;
+
+      if (next >= len) {
+        next = len;
+      } else {
+        next = fl_utf8back(text + next, text + end, text + len) - text;
+
+        if (next <= end) {
+          next = end + MEASURE_STEP;
+        }
+      }
+
+      w += fl_width(text + end, static_cast<int>(next - end));
+      end = next;
+    }
+    len = end;
+  }
+
+  if (memchr(text, '\t', len)) {
+    /* expand tabs and move the style runs accordingly */
+    buf.clear();
+    size_t col = 0, r = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+      while (r < runs_.size() && runs_[r].offset == i) {
+        runs_[r++].offset = buf.size();
+      }
+
+      if (text[i] == '\t') {
+        size_t spaces = TAB_WIDTH - (col % TAB_WIDTH);
+        buf.append(spaces, ' ');
+        col += spaces;
+      } else {
+        buf.push_back(text[i]);
+        /* count UTF-8 sequences, not bytes */
+        if ((text[i] & 0xC0) != 0x80) {
+          col++;
+        }
+      }
+    }
+
+    text = buf.data();
+    len = buf.size();
+  }
+
+  /* split the line into segments of the same style */
+  segments_.clear();
+  segment seg = { 0, 0, 0, X, 0 };
+
+  for (size_t r = 0; r < runs_.size(); ++r) {
+    size_t offset = (runs_[r].offset < len) ? runs_[r].offset : len;
+
+    if (offset > seg.begin) {
+      seg.end = offset;
+      segments_.push_back(seg);
+      seg.begin = offset;
+    }
+    seg.style = runs_[r].style;
+  }
+
+  seg.end = len;
+  segments_.push_back(seg);
+
+  int x = X;
+
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    segment &s = segments_[i];
+    fl_font(style_font(source_->style(s.style)), textsize_);
+    s.x = x;
+    s.w = static_cast<int>(fl_width(text + s.begin, static_cast<int>(s.end - s.begin)));
+    x += s.w;
+  }
+
+  /* backgrounds */
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const segment &s = segments_[i];
+    const text_style &st = source_->style(s.style);
+    Fl_Color bg = (st.flags & text_style::BG) ? st.bg : color();
+
+    if (st.flags & text_style::INVERSE) {
+      bg = (st.flags & text_style::FG) ? st.fg : FL_FOREGROUND_COLOR;
+    } else if (!(st.flags & text_style::BG)) {
+      continue;
+    }
+
+    fl_color(active_r() ? bg : fl_inactive(bg));
+    fl_rectf(s.x, Y, s.w, H);
+  }
+
+  /* search hits */
+  if (!highlight_.empty()) {
+    const char *p = text;
+    const char *end = text + len;
+    const char *m;
+
+    while ((m = reinterpret_cast<const char *>(memmem(p, end - p, highlight_.data(), highlight_.size()))) != NULL) {
+      int x1 = x_at(text, m - text);
+      p = m + highlight_.size();
+      int x2 = x_at(text, p - text);
+      fl_color(FL_YELLOW);
+      fl_rectf(x1, Y, x2 - x1, H);
+    }
+  }
+
+  fl_font(textfont_, textsize_);
+  int baseline = Y + fl_height() - fl_descent();
+
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const segment &s = segments_[i];
+    const text_style &st = source_->style(s.style);
+    Fl_Color fg = (st.flags & text_style::FG) ? st.fg : FL_FOREGROUND_COLOR;
+
+    if (st.flags & text_style::INVERSE) {
+      fg = (st.flags & text_style::BG) ? st.bg : color();
+    }
+
+    if (s.end == s.begin) {
+      continue;
+    }
+
+    fl_font(style_font(st), textsize_);
+    fl_color(active_r() ? fg : fl_inactive(fg));
+    fl_draw(text + s.begin, static_cast<int>(s.end - s.begin), s.x, baseline);
+
+    if (st.flags & text_style::UNDERLINE) {
+      fl_xyline(s.x, baseline + 1, s.x + s.w - 1);
+    }
+  }
+}
+
+void text_view::draw()
+{
+  int X = x() + Fl::box_dx(box());
+  int Y = y() + Fl::box_dy(box());
+  int W = text_w();
+  int H = text_h();
+  int lh = line_height();
+
+  draw_box();
+
+  fl_push_clip(X, Y, W, H);
+
+  source_->lock();
+
+  /* lines before source_->first() may already have been dropped */
+  size_t first = source_->first();
+
+  for (size_t n = top_; n < end_ && n < source_->end(); ++n) {
+    int ly = Y + static_cast<int>(n - top_) * lh;
+
+    if (ly >= Y + H) {
+      break;
+    }
+
+    if (n == marked_) {
+      fl_color(fl_color_average(FL_SELECTION_COLOR, color(), 0.3f));
+      fl_rectf(X, ly, W, lh);
+    }
+
+    if (n >= first) {
+      draw_line(n, X + 2 - hpos_, ly, lh);
+    }
+  }
+
+  source_->unlock();
+  fl_pop_clip();
+
+  draw_child(*vscroll_);
+
+  if (hscroll_->visible()) {
+    draw_child(*hscroll_);
+
+    /* the square between both scrollbars */
+    fl_color(FL_BACKGROUND_COLOR);
+    fl_rectf(vscroll_->x(), hscroll_->y(), vscroll_->w(), hscroll_->h());
+  }
+}
+
+int text_view::handle(int event)
+{
+  if (Fl_Group::handle(event)) {
+    return 1;
+  }
+
+  switch (event) {
+    case FL_FOCUS:
+    case FL_UNFOCUS:
+      return 1;
+
+    case FL_PUSH:
+      take_focus();
+      return 1;
+
+    case FL_MOUSEWHEEL:
+      if (Fl::event_dy() < 0) {
+        size_t n = -Fl::event_dy() * WHEEL_LINES;
+        scroll_to(top_ > n ? top_ - n : 0);
+      } else if (Fl::event_dy() > 0) {
+        scroll_to(top_ + Fl::event_dy() * WHEEL_LINES);
+      }
+      return 1;
+
+    case FL_KEYBOARD:
+      switch (Fl::event_key()) {
+        case FL_Up:
+          scroll_to(top_ > 0 ? top_ - 1 : 0);
+          return 1;
+        case FL_Down:
+          scroll_to(top_ + 1);
+          return 1;
+        case FL_Page_Up: {
+            size_t n = visible_lines();
+            scroll_to(top_ > n ? top_ - n : 0);
+          }
+          return 1;
+        case FL_Page_Down:
+          scroll_to(top_ + visible_lines());
+          return 1;
+        case FL_Home:
+          scroll_to(first_);
+          return 1;
+        case FL_End:
+          scroll_to(end_);
+          return 1;
+        case FL_Left:
+          if (hscroll_->visible()) {
+            hpos_ = (hpos_ > HSCROLL_STEP) ? hpos_ - HSCROLL_STEP : 0;
+            update_scrollbars();
+            redraw();
+          }
+          return 1;
+        case FL_Right:
+          if (hscroll_->visible()) {
+            hpos_ += HSCROLL_STEP;
+            update_scrollbars();
+            redraw();
+          }
+          return 1;
+      }
+      break;
+  }
+
+  return 0;
+}
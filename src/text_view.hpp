@@ -0,0 +1,328 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TEXT_VIEW_HPP
+#define TEXT_VIEW_HPP
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stddef.h>
+
+#include "fltk-dialog.hpp"
+
+
+/* Character attributes set by ANSI SGR escape sequences */
+struct text_style
+{
+  enum {
+    FG        = 1 << 0,  /* fg is set */
+    BG        = 1 << 1,  /* bg is set */
+    BOLD      = 1 << 2,
+    UNDERLINE = 1 << 3,
+    INVERSE   = 1 << 4
+  };
+
+  Fl_Color fg, bg;
+  unsigned char flags;
+};
+
+/* the text of a line starting at offset uses style number style */
+struct style_run
+{
+  uint32_t offset;
+  uint16_t style;
+};
+
+
+/* Line oriented text as seen by text_view.  Lines may be appended at any
+ * time, so all access must be done with lock() held. */
+class text_source
+{
+public:
+  virtual ~text_source() {}
+
+  virtual void lock() = 0;
+  virtual void unlock() = 0;
+
+  /* lines are numbered from first() to end() - 1 */
+  virtual size_t first() const = 0;
+  virtual size_t end() const = 0;
+
+  /* returns the line without its newline character */
+  virtual const char *line(size_t n, size_t &len) const = 0;
+
+  /* length of the longest line in bytes */
+  virtual size_t longest() const = 0;
+
+  /* append the style runs of line n to runs; text before the first run
+   * and lines without runs use style 0, the default style */
+  virtual void line_runs(size_t, std::vector<style_run> &) const {}
+
+  virtual const text_style &style(unsigned int) const {
+    static const text_style default_style = { 0, 0, 0 };
+    return default_style;
+  }
+};
+
+
+/* Append-only text storage.  Text is kept in large chunks and lines are
+ * references into those chunks, so appending a block of text costs one
+ * memcpy() and one newline scan and nothing is allocated per line.
+ * With a limit set the oldest lines are dropped from the front and their
+ * chunks are released once no line refers to them anymore.  Line numbers
+ * keep counting up, so first() grows as lines are dropped.
+ * ANSI escape sequences are removed from the text.  Colors and attributes
+ * are kept as style runs, which are only stored where the style changes
+ * and at the beginning of lines that don't start in the default style.
+ * append() is called from a reader thread; everything else must be done
+ * with lock() held. */
+class text_store : public text_source
+{
+public:
+  text_store();
+  virtual ~text_store();
+
+  /* keep at most max_lines lines or max_bytes bytes of text, dropping the
+   * oldest lines first; 0 means no limit */
+  void limit(size_t max_lines, size_t max_bytes);
+
+  void append(const char *data, size_t len);
+
+  /* add the last line if the text didn't end with a newline */
+  void finish();
+
+  virtual void lock() { pthread_mutex_lock(&mutex_); }
+  virtual void unlock() { pthread_mutex_unlock(&mutex_); }
+  virtual size_t first() const { return first_; }
+  virtual size_t end() const { return first_ + lines_.size(); }
+  virtual const char *line(size_t n, size_t &len) const;
+  virtual size_t longest() const { return longest_; }
+  virtual void line_runs(size_t n, std::vector<style_run> &runs) const;
+  virtual const text_style &style(unsigned int id) const { return styles_[id]; }
+
+private:
+  struct chunk {
+    char *data;
+    size_t size, used;
+  };
+
+  /* run is the number of the line's first style run, the line's runs end
+   * where the next line's runs begin; run numbers may wrap around */
+  struct line_ref {
+    const char *ptr;
+    uint32_t len;
+    uint32_t run;
+  };
+
+  enum {
+    ESC_NONE,
+    ESC_START,  /* ESC was read */
+    ESC_CSI,    /* ESC [ */
+    ESC_OSC,    /* ESC ] */
+    ESC_OSC_ESC /* ESC inside of OSC */
+  };
+
+  std::deque<chunk> chunks_;
+  std::deque<line_ref> lines_;
+  std::deque<style_run> runs_;
+  std::vector<text_style> styles_;
+  typedef std::pair<uint64_t, unsigned char> style_key;
+  std::map<style_key, uint16_t> style_ids_;
+  chunk spare_;
+  size_t first_, partial_, longest_, bytes_;
+  size_t max_lines_, max_bytes_;
+  uint32_t runs_first_;  /* number of runs_.front() */
+  uint32_t line_run_;    /* first run of the unterminated line */
+  text_style current_;
+  uint16_t style_;       /* style number of current_ */
+  int esc_state_;
+  std::string esc_;
+  pthread_mutex_t mutex_;
+
+  void add_chunk(size_t min_size);
+  void add_line(const char *ptr, size_t len);
+  void add_text(const char *data, size_t len);
+  size_t parse_escape(const char *p, size_t len);
+  void set_sgr(const std::string &params);
+  void set_style();
+  void trim();
+};
+
+
+/* A memory-mapped file.  Only the offset of every INDEX_STEP-th line is
+ * kept, other lines are found by scanning forward from the nearest index
+ * entry.  The index is built by index(), which is meant to be run in a
+ * background thread; lines become visible as soon as they were scanned.
+ *
+ * If the file is truncated while it's mapped, reading the pages past its
+ * new end raises SIGBUS.  A handler maps zero pages over the rest of the
+ * mapping instead, so the text there reads as NUL bytes, and index() stops
+ * at the new end of the file.  Only one file can be mapped at a time. */
+class mapped_text : public text_source
+{
+public:
+  mapped_text();
+  virtual ~mapped_text();
+
+  /* prints an error message and returns false on failure */
+  bool open(const char *file);
+
+  /* scan the whole file, calling cb() each time new lines were indexed */
+  void index(void (*cb)());
+
+  virtual void lock() { pthread_mutex_lock(&mutex_); }
+  virtual void unlock() { pthread_mutex_unlock(&mutex_); }
+  virtual size_t first() const { return 0; }
+  virtual size_t end() const { return lines_; }
+  virtual const char *line(size_t n, size_t &len) const;
+  virtual size_t longest() const { return longest_; }
+
+private:
+  const char *data_;
+  size_t size_;
+  int fd_;
+  std::vector<size_t> index_;
+  size_t lines_, longest_;
+  pthread_mutex_t mutex_;
+
+  /* returns the current size of the file if it shrank, else size_ */
+  size_t check_size();
+
+  /* the last line looked up; lines are usually requested in order */
+  mutable size_t cache_line_, cache_off_;
+};
+
+
+/* Searches a text_source on a worker thread.  Only lines that weren't
+ * searched before are scanned when wakeup() reports new text, and lines
+ * stored back-to-back are scanned in one memmem() call each. */
+class text_search
+{
+public:
+  /* notify() is called from the worker thread when new hits were found */
+  text_search(text_source *source, void (*notify)());
+
+  bool start();
+
+  /* start a new search; an empty string stops searching */
+  void query(const std::string &s);
+
+  /* call when lines were appended to the source */
+  void wakeup();
+
+  /* number of lines with a hit found so far */
+  size_t count();
+
+  /* find the next/previous line with a hit, wrapping around */
+  bool next(size_t from, size_t &n);
+  bool prev(size_t from, size_t &n);
+
+private:
+  text_source *source_;
+  void (*notify_)();
+  pthread_t thread_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  std::string query_;
+  std::deque<size_t> hits_;
+  unsigned int generation_;
+  bool pending_;
+
+  void run();
+  void scan(const std::string &q, size_t from, size_t to, std::vector<size_t> &found);
+  static void *worker(void *v);
+};
+
+
+/* Displays the lines of a text_source, drawing only the visible ones. */
+class text_view : public Fl_Group
+{
+public:
+  text_view(int X, int Y, int W, int H, text_source *source);
+
+  /* pick up lines appended since the last call; call once per frame */
+  void sync();
+
+  bool autoscroll() const { return autoscroll_; }
+  void autoscroll(bool b) { autoscroll_ = b; }
+
+  Fl_Font textfont() const { return textfont_; }
+  void textfont(Fl_Font f) { textfont_ = f; }
+
+  Fl_Fontsize textsize() const { return textsize_; }
+  void textsize(Fl_Fontsize s) { textsize_ = s; }
+
+  /* highlight all occurrences of s in the visible lines */
+  void highlight(const std::string &s);
+
+  /* scroll line n into view and mark it */
+  void show_line(size_t n);
+
+  /* the marked line or the first visible one */
+  size_t current_line() const;
+
+  int handle(int event);
+  void resize(int X, int Y, int W, int H);
+
+protected:
+  void draw();
+
+private:
+  text_source *source_;
+  Fl_Scrollbar *vscroll_, *hscroll_;
+  Fl_Font textfont_;
+  Fl_Fontsize textsize_;
+  size_t top_, first_, end_, longest_;
+  size_t marked_;
+  int hpos_;
+  bool autoscroll_;
+  std::string highlight_;
+
+  int line_height() const;
+  int visible_lines() const;
+  int text_w() const;
+  int text_h() const;
+  void scroll_to(size_t top);
+  void update_scrollbars();
+  struct segment {
+    size_t begin, end;
+    unsigned int style;
+    int x, w;
+  };
+
+  std::vector<style_run> runs_;
+  std::vector<segment> segments_;
+
+  Fl_Font style_font(const text_style &st) const;
+  int x_at(const char *text, size_t offset) const;
+  void draw_line(size_t n, int X, int Y, int H);
+
+  static void vscroll_cb(Fl_Widget *, void *v);
+  static void hscroll_cb(Fl_Widget *, void *v);
+};
+
+#endif  /* !TEXT_VIEW_HPP */
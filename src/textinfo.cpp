@@ -22,18 +22,34 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <errno.h>
 #include <stdio.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <zlib.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
 #include "fltk-dialog.hpp"
+#include "bench.hpp"
+#include "frame_update.hpp"
+#include "text_view.hpp"
+
+#define READ_SIZE       (64*1024)
+#define INFLATE_SIZE    (256*1024)
+#define SEARCH_H        26
 
 /***
 
+Ctrl+F opens a search bar, F3 and Shift+F3 jump to the next/previous hit.
+
 (echo "Line 1/5"; n=2; \
  while (test $n -le 5); do \
  sleep 1; echo "Line $n/5"; n=$(($((n))+1)); done \
@@ -43,7 +59,16 @@
 ***/
 
 static Fl_Double_Window *win;
-static Fl_Multi_Browser *browser;
+static text_store *store = NULL;
+static mapped_text *mapped = NULL;
+static const char *follow_path = NULL;
+static int follow_fd = -1;
+static int input_fd = STDIN_FILENO;
+static text_view *view;
+static text_search *search;
+static Fl_Group *search_bar;
+static Fl_Input *search_input;
+static Fl_Box *search_count;
 static Fl_Check_Button *checkbutton = NULL;
 static Fl_Return_Button *but_ok;
 static int ret = 1;
@@ -72,27 +97,127 @@ static void callback(Fl_Widget *)
   }
 }
 
-extern "C" void *ti_getline(void *)
+/* the text view with the search bar below it */
+class text_area : public Fl_Group
 {
-  char *line = NULL;
-  size_t len = 0;
-  int i = 0;
+public:
+  text_area(int X, int Y, int W, int H)
+    : Fl_Group(X, Y, W, H)
+  { }
+
+  void resize(int X, int Y, int W, int H) {
+    Fl_Widget::resize(X, Y, W, H);
+    layout();
+  }
 
-  while (getline(&line, &len, stdin) != -1) {
-    Fl::lock();
-    i++;
-    browser->add(line);
-    if (autoscroll) {
-      browser->bottomline(i);
-    }
-    Fl::unlock();
-    Fl::awake();
+  void layout() {
+    int bar_h = search_bar->visible() ? SEARCH_H + 4 : 0;
+    view->resize(x(), y(), w(), h() - bar_h);
+    search_bar->resize(x(), y() + h() - SEARCH_H, w(), SEARCH_H);
+  }
+};
+
+static text_area *area;
+
+static void update_count()
+{
+  size_t n = search->count();
+  std::string s = std::to_string(n) + ((n == 1) ? " match" : " matches");
+  search_count->copy_label(s.c_str());
+}
+
+static void frame_cb()
+{
+  view->sync();
+
+  if (search_bar->visible()) {
+    update_count();
+  }
+}
+
+static frame_update frame(frame_cb);
+
+/* new text is picked up at most once per frame */
+static void schedule_update()
+{
+  frame.request();
+}
+
+static void text_added()
+{
+  search->wakeup();
+  schedule_update();
+}
+
+static void find(bool forward)
+{
+  size_t from = view->current_line();
+  size_t n;
+
+  if (forward ? search->next(from, n) : search->prev(from, n)) {
+    view->autoscroll(false);
+    view->show_line(n);
   }
+}
 
-  if (line) {
-    free(line);
+static void search_cb(Fl_Widget *)
+{
+  if (Fl::event() == FL_KEYBOARD && Fl::event_key() == FL_Enter) {
+    find(!Fl::event_shift());
+    return;
   }
 
+  /* the search worker only scans new text when the query is unchanged */
+  search->query(search_input->value());
+  view->highlight(search_input->value());
+  update_count();
+}
+
+static void show_search_bar(bool show)
+{
+  if (show) {
+    search_bar->show();
+    search_input->take_focus();
+    search_cb(NULL);
+  } else {
+    search_bar->hide();
+    search->query("");
+    view->highlight("");
+    view->take_focus();
+  }
+  area->layout();
+  area->redraw();
+}
+
+static int search_handler(int event)
+{
+  if (event != FL_SHORTCUT) {
+    return 0;
+  }
+
+  switch (Fl::event_key()) {
+    case 'f':
+      if (Fl::event_ctrl()) {
+        show_search_bar(true);
+        return 1;
+      }
+      break;
+    case FL_F + 3:
+      find(!Fl::event_shift());
+      return 1;
+    case FL_Escape:
+      if (search_bar->visible()) {
+        show_search_bar(false);
+        return 1;
+      }
+      break;
+  }
+
+  return 0;
+}
+
+static void input_done()
+{
   Fl::lock();
 
   if (autoclose) {
@@ -107,11 +232,282 @@ extern "C" void *ti_getline(void *)
 
   Fl::unlock();
   Fl::awake();
+}
+
+/* the store has its own lock, Fl::lock() is not needed here */
+static void add_text(const char *buf, size_t len)
+{
+  bench_input(std::count(buf, buf + len, '\n'));
+  store->append(buf, len);
+  text_added();
+}
+
+/* returns 0 on EOF and -1 on error */
+static ssize_t read_block(int fd, char *buf)
+{
+  for (;;) {
+    ssize_t n = read(fd, buf, READ_SIZE);
+
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("read()");
+    }
+    return n;
+  }
+}
+
+static bool read_to_eof(int fd, char *buf)
+{
+  ssize_t n;
+
+  while ((n = read_block(fd, buf)) > 0) {
+    add_text(buf, n);
+  }
+
+  return (n == 0);
+}
+
+/* gzip or zlib header */
+static bool is_compressed(const unsigned char *p, size_t len)
+{
+  if (len < 2) {
+    return false;
+  }
+
+  if (p[0] == 0x1f && p[1] == 0x8b) {
+    return true;
+  }
+
+  /* deflate with a window of up to 32K, no preset dictionary and a valid
+   * header checksum */
+  return ((p[0] & 0x0f) == Z_DEFLATED && (p[0] >> 4) <= 7 && (p[1] & 0x20) == 0 &&
+          ((p[0] << 8) | p[1]) % 31 == 0);
+}
+
+/* Inflate the input while reading it, so the text shows up before the
+ * whole file was decompressed.  buf holds the first n bytes of input.
+ * Concatenated gzip members are supported.  Until there is some output the
+ * raw input is kept, so if it turns out not to be compressed after all (a
+ * zlib header is only two bytes) it can be shown as it is. */
+static void inflate_to_eof(int fd, char *buf, ssize_t n)
+{
+  z_stream zs;
+  char *out;
+  std::string raw;
+  bool gzip = (n >= 2 && buf[0] == '\x1f' && buf[1] == '\x8b');
+  bool have_output = false, stream_end = false;
+  int rv;
+
+  memset(&zs, 0, sizeof(zs));
+
+  /* 15 + 32: zlib or gzip format, detected automatically */
+  if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+    std::cerr << "error: inflateInit2() failed" << std::endl;
+    add_text(buf, n);
+    read_to_eof(fd, buf);
+    return;
+  }
+
+  out = new char[INFLATE_SIZE];
+
+  while (n > 0) {
+    if (!have_output) {
+      raw.append(buf, n);
+    }
+
+    zs.next_in = reinterpret_cast<Bytef *>(buf);
+    zs.avail_in = static_cast<uInt>(n);
+
+    for (;;) {
+      zs.next_out = reinterpret_cast<Bytef *>(out);
+      zs.avail_out = INFLATE_SIZE;
 
+      rv = inflate(&zs, Z_NO_FLUSH);
+
+      size_t have = INFLATE_SIZE - zs.avail_out;
+      if (have > 0) {
+        add_text(out, have);
+        have_output = true;
+        raw.clear();
+      }
+
+      if (rv == Z_STREAM_END) {
+        /* another gzip member may follow */
+        stream_end = true;
+        inflateReset(&zs);
+      } else if (rv == Z_OK) {
+        stream_end = false;
+      } else if (rv == Z_BUF_ERROR) {
+        /* needs more input */
+        break;
+      } else if (!have_output) {
+        /* not compressed after all */
+        add_text(raw.data(), raw.size());
+        read_to_eof(fd, buf);
+        stream_end = true;
+        n = 0;
+        break;
+      } else if (stream_end) {
+        /* trailing garbage, e.g. zero padding */
+        n = 0;
+        break;
+      } else {
+        std::cerr << "error: inflate(): " << (zs.msg ? zs.msg : "data error") << std::endl;
+        stream_end = true;
+        n = 0;
+        break;
+      }
+
+      if (zs.avail_in == 0 && zs.avail_out > 0) {
+        break;
+      }
+    }
+
+    if (n > 0) {
+      n = read_block(fd, buf);
+    }
+  }
+
+  if (!stream_end) {
+    if (!have_output && !gzip) {
+      /* too short to tell, so it's probably not compressed */
+      add_text(raw.data(), raw.size());
+    } else {
+      std::cerr << "error: compressed input is truncated" << std::endl;
+    }
+  }
+
+  inflateEnd(&zs);
+  delete[] out;
+}
+
+extern "C" void *ti_read(void *)
+{
+  char *buf = new char[READ_SIZE];
+  ssize_t n = read_block(input_fd, buf);
+
+  if (n > 0 && is_compressed(reinterpret_cast<unsigned char *>(buf), n)) {
+    inflate_to_eof(input_fd, buf, n);
+  } else if (n > 0) {
+    add_text(buf, n);
+    read_to_eof(input_fd, buf);
+  }
+
+  delete[] buf;
+
+  store->finish();
+  text_added();
+  input_done();
+
+  return nullptr;
+}
+
+#define FOLLOW_MASK  (IN_MODIFY|IN_MOVE_SELF|IN_DELETE_SELF)
+
+/* like `tail -F': keep reading appended data, start over if the file was
+ * truncated and switch to the new file if it was replaced */
+extern "C" void *ti_follow(void *)
+{
+  char *buf = new char[READ_SIZE];
+  char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  std::string dir = follow_path, base = follow_path;
+  struct stat st, st_path;
+  int fd = follow_fd;
+  int wd = -1, dir_wd = -1;
+
+  read_to_eof(fd, buf);
+  input_done();
+
+  int ifd = inotify_init1(IN_CLOEXEC);
+
+  if (ifd == -1) {
+    perror("inotify_init1()");
+    std::cerr << "falling back to polling" << std::endl;
+  } else {
+    /* watch the directory for the file being created again after a rotation */
+    dir_wd = inotify_add_watch(ifd, dirname(&dir[0]), IN_CREATE|IN_MOVED_TO);
+    wd = inotify_add_watch(ifd, follow_path, FOLLOW_MASK);
+  }
+
+  const char *name = basename(&base[0]);
+
+  for (;;) {
+    bool modified = false, replaced = false;
+
+    if (ifd == -1) {
+      sleep(1);
+      modified = replaced = true;
+    } else {
+      ssize_t len = read(ifd, events, sizeof(events));
+
+      if (len == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        perror("read()");
+        break;
+      }
+
+      for (char *p = events; p < events + len; ) {
+        struct inotify_event *ev = reinterpret_cast<struct inotify_event *>(p);
+
+        if (ev->wd == wd) {
+          if (ev->mask & IN_MODIFY) {
+            modified = true;
+          }
+          if (ev->mask & (IN_MOVE_SELF|IN_DELETE_SELF)) {
+            replaced = true;
+          }
+        } else if (ev->wd == dir_wd && ev->len > 0 && strcmp(ev->name, name) == 0) {
+          replaced = true;
+        }
+        p += sizeof(struct inotify_event) + ev->len;
+      }
+    }
+
+    if (modified) {
+      if (fstat(fd, &st) == 0 && st.st_size < lseek(fd, 0, SEEK_CUR)) {
+        /* truncated */
+        lseek(fd, 0, SEEK_SET);
+      }
+      read_to_eof(fd, buf);
+    }
+
+    if (replaced && stat(follow_path, &st_path) == 0 && fstat(fd, &st) == 0 &&
+        (st.st_ino != st_path.st_ino || st.st_dev != st_path.st_dev))
+    {
+      int new_fd = open(follow_path, O_RDONLY|O_CLOEXEC);
+
+      if (new_fd != -1) {
+        /* read what was written to the old file before it was rotated */
+        read_to_eof(fd, buf);
+        close(fd);
+        fd = new_fd;
+
+        if (ifd != -1) {
+          inotify_rm_watch(ifd, wd);
+          wd = inotify_add_watch(ifd, follow_path, FOLLOW_MASK);
+        }
+        read_to_eof(fd, buf);
+      }
+    }
+  }
+
+  delete[] buf;
+  return nullptr;
+}
+
+extern "C" void *ti_index(void *)
+{
+  mapped->index(text_added);
+  input_done();
   return nullptr;
 }
 
-int dialog_textinfo(bool autoscroll_, const char *checkbox, bool autoclose_, bool hide_cancel_)
+int dialog_textinfo(bool autoscroll_, const char *checkbox, bool autoclose_, bool hide_cancel_, const char *filename,
+                    bool follow, size_t max_lines, size_t max_bytes)
 {
   Fl_Group *g;
   Fl_Box *dummy;
@@ -123,13 +519,66 @@ int dialog_textinfo(bool autoscroll_, const char *checkbox, bool autoclose_, boo
   autoclose = autoclose_;
   hide_cancel = hide_cancel_;
 
+  if (filename && follow) {
+    if ((follow_fd = open(filename, O_RDONLY|O_CLOEXEC)) == -1) {
+      perror("open()");
+      return 1;
+    }
+    follow_path = filename;
+  } else if (filename) {
+    unsigned char magic[2];
+    int fd = open(filename, O_RDONLY|O_CLOEXEC);
+
+    if (fd != -1 && pread(fd, magic, sizeof(magic), 0) == sizeof(magic) && is_compressed(magic, sizeof(magic))) {
+      /* compressed files are inflated into the text store */
+      input_fd = fd;
+    } else {
+      if (fd != -1) {
+        close(fd);
+      }
+      mapped = new mapped_text();
+      if (!mapped->open(filename)) {
+        return 1;
+      }
+    }
+  }
+
   if (!title) {
     title = "FLTK text info window";
   }
 
-  win = new Fl_Double_Window(400, 500, title);
+  win = new bench_window(400, 500, title);
   {
-    browser = new Fl_Multi_Browser(10, 10, 380, browser_h);
+    text_source *source = mapped;
+
+    if (!mapped) {
+      store = new text_store();
+      store->limit(max_lines, max_bytes);
+      source = store;
+    }
+
+    search = new text_search(source, schedule_update);
+
+    area = new text_area(10, 10, 380, browser_h);
+    {
+      view = new text_view(10, 10, 380, browser_h, source);
+      view->autoscroll(autoscroll);
+
+      search_bar = new Fl_Group(10, 10 + browser_h - SEARCH_H, 380, SEARCH_H);
+      {
+        search_input = new Fl_Input(10, search_bar->y(), 280, SEARCH_H);
+        search_input->when(FL_WHEN_CHANGED|FL_WHEN_ENTER_KEY_ALWAYS);
+        search_input->callback(search_cb);
+        search_input->tooltip("Enter: next match\nShift+Enter: previous match\nEscape: close");
+
+        search_count = new Fl_Box(294, search_bar->y(), 96, SEARCH_H);
+        search_count->align(FL_ALIGN_LEFT|FL_ALIGN_INSIDE);
+      }
+      search_bar->resizable(search_input);
+      search_bar->end();
+      search_bar->hide();
+    }
+    area->end();
 
     if (checkbox || !autoclose || !hide_cancel) {
       win_ret = 1;
@@ -170,15 +619,20 @@ int dialog_textinfo(bool autoscroll_, const char *checkbox, bool autoclose_, boo
       g->end();
     }
   }
-  set_size(win, browser);
+  set_size(win, area);
   set_size_range(win, but_w + 40, checkbox ? 120 : 90);
   set_position(win);
   win->end();
   win->callback(close_cb, win_ret);
 
+  if (!search->start()) {
+    return 1;
+  }
+  Fl::add_handler(search_handler);
+
   Fl::lock();
 
-  int errsv = pthread_create(&th, 0, &ti_getline, NULL);
+  int errsv = pthread_create(&th, 0, mapped ? &ti_index : (follow_path ? &ti_follow : &ti_read), NULL);
 
   if (errsv != 0) {
     errno = errsv;
@@ -0,0 +1,254 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// ./build/fltk_dialog/fltk-dialog --question --text="Continue?" --trace-startup=-
+// ./build/fltk_dialog/fltk-dialog --file --native --trace-startup=trace.json
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef USE_DLOPEN
+# include <dlfcn.h>
+#endif
+
+#include "fltk-dialog.hpp"
+#include "trace.hpp"
+
+typedef struct {
+  std::string name;
+  uint64_t start;
+  uint64_t end;  /* 0 for instant events */
+  long tid;
+} trace_event;
+
+static bool enabled = false;
+static bool forked = false;
+static const char *output = NULL;
+static uint64_t t_base = 0, t_dialog = 0, t_map = 0;
+
+/* allocated on first use and never freed, so that it can be used
+ * before static initialization and after static destruction */
+static std::vector<trace_event> *events = NULL;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t trace_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/* runs before the static initializers of all other files */
+__attribute__((constructor(101)))
+static void trace_base(void) {
+  t_base = trace_now();
+}
+
+bool trace_enabled(void) {
+  return enabled;
+}
+
+static void add_event(const char *name, uint64_t start, uint64_t end)
+{
+  trace_event ev;
+
+  if (!enabled) {
+    return;
+  }
+
+  ev.name = name;
+  ev.start = start;
+  ev.end = end;
+  ev.tid = syscall(SYS_gettid);
+
+  pthread_mutex_lock(&mutex);
+  events->push_back(ev);
+  pthread_mutex_unlock(&mutex);
+}
+
+void trace_span(const char *name, uint64_t start) {
+  add_event(name, start, trace_now());
+}
+
+void trace_mark(const char *name) {
+  add_event(name, trace_now(), 0);
+}
+
+static bool by_start(const trace_event &a, const trace_event &b) {
+  return a.start < b.start;
+}
+
+static double ms(uint64_t t) {
+  return t / 1e6;
+}
+
+static void print_json_string(FILE *fp, const std::string &s)
+{
+  fputc('"', fp);
+
+  for (size_t i = 0; i < s.size(); ++i) {
+    unsigned char c = s[i];
+
+    if (c == '"' || c == '\\') {
+      fprintf(fp, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(fp, "\\u%04x", c);
+    } else {
+      fputc(c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+static void trace_write(void)
+{
+  FILE *fp;
+  int pid = getpid();
+
+  pthread_mutex_lock(&mutex);
+  std::stable_sort(events->begin(), events->end(), by_start);
+
+  if (strcmp(output, "-") == 0) {
+    fprintf(stderr, "startup trace (ms since the first static initializer):\n"
+                    "%10s %10s  %s\n", "start", "duration", "phase");
+
+    for (size_t i = 0; i < events->size(); ++i) {
+      const trace_event &ev = (*events)[i];
+
+      if (ev.end > 0) {
+        fprintf(stderr, "%10.3f %10.3f  %s\n", ms(ev.start - t_base), ms(ev.end - ev.start), ev.name.c_str());
+      } else {
+        fprintf(stderr, "%10.3f %10s  %s\n", ms(ev.start - t_base), "-", ev.name.c_str());
+      }
+    }
+  } else if ((fp = fopen(output, "w")) == NULL) {
+    perror("fopen()");
+  } else {
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (size_t i = 0; i < events->size(); ++i) {
+      const trace_event &ev = (*events)[i];
+
+      fprintf(fp, "{\"name\":");
+      print_json_string(fp, ev.name);
+
+      /* timestamps are in microseconds */
+      if (ev.end > 0) {
+        fprintf(fp, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", (ev.start - t_base) / 1e3, (ev.end - ev.start) / 1e3);
+      } else {
+        fprintf(fp, ",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.3f", (ev.start - t_base) / 1e3);
+      }
+      fprintf(fp, ",\"pid\":%d,\"tid\":%ld}%s\n", pid, ev.tid, (i + 1 < events->size()) ? "," : "");
+    }
+
+    fprintf(fp, "]}\n");
+    fclose(fp);
+  }
+
+  pthread_mutex_unlock(&mutex);
+}
+
+/* the option is parsed by hand since the argument parser itself is traced */
+void trace_init(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--trace-startup=", 16) == 0) {
+      output = argv[i] + 16;
+    } else if (strcmp(argv[i], "--trace-startup") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    }
+  }
+
+  if (!output || *output == '\0') {
+    return;
+  }
+
+  events = new std::vector<trace_event>;
+  enabled = true;
+  atexit(trace_write);
+
+  if (!forked) {
+    trace_span("static initialization", t_base);
+  }
+}
+
+void trace_fork(void)
+{
+  t_base = trace_now();
+  forked = true;
+}
+
+static int trace_x_event(void *event, void *)
+{
+  XEvent *xev = static_cast<XEvent *>(event);
+
+  if (xev->type == MapNotify && t_map == 0) {
+    trace_span("create and show window", t_dialog);
+    t_map = trace_now();
+  } else if (xev->type == Expose && t_map > 0) {
+    trace_span("first expose", t_map);
+    Fl::remove_system_handler(trace_x_event);
+  }
+  return 0;
+}
+
+void trace_dialog_start(void)
+{
+  if (enabled) {
+    t_dialog = trace_now();
+    Fl::add_system_handler(trace_x_event, NULL);
+  }
+}
+
+#ifdef USE_DLOPEN
+void *trace_dlopen(const char *file, int mode)
+{
+  std::string name;
+  uint64_t t;
+  void *handle;
+
+  if (!enabled) {
+    return dlopen(file, mode);
+  }
+
+  t = trace_now();
+  handle = dlopen(file, mode);
+
+  name = "dlopen ";
+  name += file ? file : "(main program)";
+  if (!handle) {
+    name += " (failed)";
+  }
+  trace_span(name.c_str(), t);
+
+  return handle;
+}
+#endif  /* USE_DLOPEN */
@@ -0,0 +1,68 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020, djcj <djcj@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <stdint.h>
+
+/* Startup tracing with `--trace-startup=FILE'.
+ *
+ * The phases of a dialog's startup are recorded with monotonic timestamps
+ * and written out when the process exits: as a table on stderr if FILE is
+ * `-', otherwise as Chrome trace-event JSON (load it in chrome://tracing
+ * or https://ui.perfetto.dev).  All times are relative to the earliest
+ * static initializer, so dynamic linking is not included.  A dialog that
+ * was started by the dialog server is traced from the moment it was forked.
+ *
+ *   uint64_t t = trace_now();
+ *   l10n();
+ *   trace_span("l10n", t);
+ */
+
+/* scan argv for --trace-startup; call before the arguments are parsed */
+void trace_init(int argc, char **argv);
+
+/* restart the clock in a child of the dialog server */
+void trace_fork(void);
+
+bool trace_enabled(void);
+uint64_t trace_now(void);
+
+/* record a phase that started at `start' and ends now */
+void trace_span(const char *name, uint64_t start);
+
+/* record an instant event */
+void trace_mark(const char *name);
+
+#ifdef USE_DLOPEN
+/* dlopen() that records the time it took */
+void *trace_dlopen(const char *file, int mode);
+#endif
+
+/* the dialog is set up now; its first window's map and expose
+ * events are recorded (the display must be open) */
+void trace_dialog_start(void);
+
+#endif  /* !TRACE_HPP */